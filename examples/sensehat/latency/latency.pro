@@ -0,0 +1,9 @@
+QT += sensehat
+CONFIG += c++11
+
+SOURCES = main.cpp
+
+target.path = $$[QT_INSTALL_EXAMPLES]/sensehat/latency
+sources.files = $$SOURCES $$HEADERS $$RESOURCES $$FORMS latency.pro
+sources.path = $$[QT_INSTALL_EXAMPLES]/sensehat/latency
+INSTALLS += target sources
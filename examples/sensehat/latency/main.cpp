@@ -0,0 +1,191 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the examples of the Qt Sense Hat module
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of The Qt Company Ltd nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+// Measures how long it takes from reading an IMU sample to the corresponding
+// pixels landing in the framebuffer. Runs against the simulated sensors and a
+// file-backed framebuffer, so it works without the HAT. tests/benchmarks/latency
+// runs the same pipeline as a test with a p99 limit.
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QImage>
+#include <QPainter>
+#include <QTemporaryFile>
+#include <QThread>
+#include <QSenseHatFb>
+#include <QSenseHatSensorCore>
+#include <QVector3D>
+#include <algorithm>
+#include <time.h>
+
+static quint64 monotonicUSecs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return quint64(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+enum Stage {
+    Acquire,    // read() called -> sample read from the bus and fused
+    Delivery,   // read() returned -> queued slot running on the GUI thread
+    Paint,      // slot entered -> QPainter done on an offscreen frame
+    Write,      // QPainter done -> drawImage() and present() returned, pixels are in the mmap
+    Total,
+    StageCount
+};
+
+static const char *stageNames[StageCount] = { "acquire", "delivery", "paint", "fb write", "total" };
+
+class Probe : public QObject
+{
+    Q_OBJECT
+
+signals:
+    void sampled(quint64 started, quint64 acquired, const QVector3D &orientation);
+};
+
+class SensorThread : public QThread
+{
+public:
+    SensorThread(Probe *probe) : probe(probe) { }
+
+protected:
+    void run() Q_DECL_OVERRIDE
+    {
+        // Drive the core directly, so that the time spent on the bus is part of the measurement.
+        QSenseHatSensorCore core(QSenseHatSensorCore::Simulated);
+        if (!core.init(QSenseHatSensorCore::Orientation))
+            return;
+        QSenseHatSensorSample sample;
+        while (!isInterruptionRequested()) {
+            const quint64 started = monotonicUSecs();
+            if (core.read(sample, QSenseHatSensorCore::Orientation)
+                    && (sample.valid & QSenseHatSensorCore::Orientation)) {
+                const QVector3D v(sample.orientation[0], sample.orientation[1], sample.orientation[2]);
+                emit probe->sampled(started, monotonicUSecs(), v);
+            }
+            msleep(core.pollInterval());
+        }
+    }
+
+private:
+    Probe *probe;
+};
+
+static void printStats(const char *name, QVector<quint64> v)
+{
+    std::sort(v.begin(), v.end());
+    auto pct = [&v](int p) { return v.at(qMin(v.count() - 1, v.count() * p / 100)); };
+    printf("%-9s min %6llu  p50 %6llu  p90 %6llu  p99 %6llu  max %6llu us\n", name,
+           v.first(), pct(50), pct(90), pct(99), v.last());
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Sense HAT motion-to-LED latency"));
+    parser.addHelpOption();
+    QCommandLineOption samplesOption(QStringLiteral("samples"), QStringLiteral("Number of samples."),
+                                     QStringLiteral("count"), QStringLiteral("1000"));
+    QCommandLineOption maxOption(QStringLiteral("max-p99"), QStringLiteral("Fail if the total p99 exceeds this."),
+                                 QStringLiteral("us"));
+    parser.addOption(samplesOption);
+    parser.addOption(maxOption);
+    parser.process(app);
+    const int sampleCount = qMax(1, parser.value(samplesOption).toInt());
+
+    QTemporaryFile fbFile;
+    if (!fbFile.open())
+        return 1;
+    QSenseHatFb fb(fbFile.fileName());
+    if (!fb.isValid())
+        return 1;
+    // Painting directly into paintDevice() would write the mmap as a side effect of QPainter,
+    // leaving nothing for the write stage to measure. Paint offscreen and copy instead.
+    QImage frame(fb.size(), QImage::Format_RGB32);
+    QPainter p(&frame);
+
+    QVector<quint64> stages[StageCount];
+    for (QVector<quint64> &s : stages)
+        s.reserve(sampleCount);
+
+    Probe probe;
+    QObject::connect(&probe, &Probe::sampled, &app, [&](quint64 started, quint64 acquired, const QVector3D &v) {
+        const quint64 delivered = monotonicUSecs();
+        p.fillRect(QRect(QPoint(), fb.size()), QColor::fromHsv(int(v.z()) % 360, 255, 255));
+        const quint64 painted = monotonicUSecs();
+        fb.drawImage(frame);
+        fb.present();
+        const quint64 presented = monotonicUSecs();
+
+        stages[Acquire].append(acquired - started);
+        stages[Delivery].append(delivered - acquired);
+        stages[Paint].append(painted - delivered);
+        stages[Write].append(presented - painted);
+        stages[Total].append(presented - started);
+        if (stages[Total].count() == sampleCount)
+            app.quit();
+    }, Qt::QueuedConnection);
+
+    SensorThread thread(&probe);
+    thread.start();
+    app.exec();
+    thread.requestInterruption();
+    thread.wait();
+
+    printf("%d samples\n", sampleCount);
+    for (int i = 0; i < StageCount; ++i)
+        printStats(stageNames[i], stages[i]);
+
+    if (parser.isSet(maxOption)) {
+        std::sort(stages[Total].begin(), stages[Total].end());
+        const quint64 p99 = stages[Total].at(qMin(sampleCount - 1, sampleCount * 99 / 100));
+        if (p99 > parser.value(maxOption).toULongLong()) {
+            printf("FAIL: total p99 %llu us exceeds %s us\n", p99, qPrintable(parser.value(maxOption)));
+            return 2;
+        }
+    }
+
+    return 0;
+}
+
+#include "main.moc"
@@ -1,2 +1,2 @@
 TEMPLATE = subdirs
-SUBDIRS += leds sensors
+SUBDIRS += leds sensors latency
@@ -0,0 +1,93 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Sense HAT module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qsensehatframesyncitem.h"
+#include <QtQuick/QQuickWindow>
+
+QT_BEGIN_NAMESPACE
+
+static const int FALLBACK_FRAME_INTERVAL_MS = 16;
+
+QSenseHatFrameSyncItem::QSenseHatFrameSyncItem(QQuickItem *parent)
+    : QQuickItem(parent)
+{
+    m_fallbackTimer.setSingleShot(true);
+    m_fallbackTimer.setInterval(FALLBACK_FRAME_INTERVAL_MS);
+    connect(&m_fallbackTimer, &QTimer::timeout, this, &QSenseHatFrameSyncItem::frame);
+}
+
+void QSenseHatFrameSyncItem::scheduleFlush()
+{
+    if (m_scheduled)
+        return;
+
+    m_scheduled = true;
+    if (m_window)
+        m_window->update();
+    else
+        m_fallbackTimer.start();
+}
+
+void QSenseHatFrameSyncItem::itemChange(ItemChange change, const ItemChangeData &value)
+{
+    if (change == ItemSceneChange) {
+        disconnect(m_connection);
+        m_window = value.window;
+        if (m_window) {
+            m_connection = connect(m_window.data(), &QQuickWindow::afterAnimating,
+                                   this, &QSenseHatFrameSyncItem::frame);
+            if (m_scheduled) {
+                m_fallbackTimer.stop();
+                m_window->update();
+            }
+        } else if (m_scheduled) {
+            m_fallbackTimer.start();
+        }
+    }
+
+    QQuickItem::itemChange(change, value);
+}
+
+void QSenseHatFrameSyncItem::frame()
+{
+    if (!m_scheduled)
+        return;
+
+    m_scheduled = false;
+    flush();
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,72 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Sense HAT module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QSENSEHATFRAMESYNCITEM_H
+#define QSENSEHATFRAMESYNCITEM_H
+
+#include <QtQuick/QQuickItem>
+#include <QtCore/QPointer>
+#include <QtCore/QTimer>
+
+QT_BEGIN_NAMESPACE
+
+// Coalesces changes so that flush() runs at most once per frame of the window
+// the item is in, or roughly at 60 Hz when it is not in a window.
+class QSenseHatFrameSyncItem : public QQuickItem
+{
+    Q_OBJECT
+
+public:
+    explicit QSenseHatFrameSyncItem(QQuickItem *parent = Q_NULLPTR);
+
+protected:
+    void scheduleFlush();
+    virtual void flush() = 0;
+
+    void itemChange(ItemChange change, const ItemChangeData &value) Q_DECL_OVERRIDE;
+
+private:
+    void frame();
+
+    QPointer<QQuickWindow> m_window;
+    QMetaObject::Connection m_connection;
+    QTimer m_fallbackTimer;
+    bool m_scheduled = false;
+};
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,125 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Sense HAT module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qsensehatquickledmatrix.h"
+#include <QtSenseHat/qsensehatfb.h>
+
+QT_BEGIN_NAMESPACE
+
+QSenseHatQuickLedMatrix::QSenseHatQuickLedMatrix(QQuickItem *parent)
+    : QSenseHatFrameSyncItem(parent),
+      m_fb(new QSenseHatFb)
+{
+    m_pixels = QImage(m_fb->size(), QImage::Format_RGB32);
+    m_pixels.fill(Qt::black);
+}
+
+QSenseHatQuickLedMatrix::~QSenseHatQuickLedMatrix()
+{
+    delete m_fb;
+}
+
+bool QSenseHatQuickLedMatrix::isValid() const
+{
+    return m_fb->isValid();
+}
+
+int QSenseHatQuickLedMatrix::columns() const
+{
+    return m_pixels.width();
+}
+
+int QSenseHatQuickLedMatrix::rows() const
+{
+    return m_pixels.height();
+}
+
+void QSenseHatQuickLedMatrix::setLowLight(bool enable)
+{
+    if (m_lowLight == enable)
+        return;
+
+    m_lowLight = enable;
+    m_fb->setLowLight(enable);
+    emit lowLightChanged();
+}
+
+QColor QSenseHatQuickLedMatrix::pixel(int x, int y) const
+{
+    if (!m_pixels.valid(x, y))
+        return QColor();
+
+    return QColor(m_pixels.pixel(x, y));
+}
+
+void QSenseHatQuickLedMatrix::setPixel(int x, int y, const QColor &color)
+{
+    if (!m_pixels.valid(x, y))
+        return;
+
+    reinterpret_cast<QRgb *>(m_pixels.scanLine(y))[x] = color.rgb();
+    scheduleFlush();
+}
+
+void QSenseHatQuickLedMatrix::setPixels(const QVariantList &colors)
+{
+    const int count = qMin(colors.count(), m_pixels.width() * m_pixels.height());
+    for (int i = 0; i < count; ++i) {
+        const int y = i / m_pixels.width();
+        reinterpret_cast<QRgb *>(m_pixels.scanLine(y))[i % m_pixels.width()] = colors.at(i).value<QColor>().rgb();
+    }
+    scheduleFlush();
+}
+
+void QSenseHatQuickLedMatrix::fill(const QColor &color)
+{
+    m_pixels.fill(color.rgb());
+    scheduleFlush();
+}
+
+void QSenseHatQuickLedMatrix::clear()
+{
+    fill(Qt::black);
+}
+
+void QSenseHatQuickLedMatrix::flush()
+{
+    // Same size, so this is a straight conversion into the framebuffer format.
+    m_fb->drawImage(m_pixels);
+    m_fb->present();
+}
+
+QT_END_NAMESPACE
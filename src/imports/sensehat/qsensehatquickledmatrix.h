@@ -0,0 +1,88 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Sense HAT module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QSENSEHATQUICKLEDMATRIX_H
+#define QSENSEHATQUICKLEDMATRIX_H
+
+#include "qsensehatframesyncitem.h"
+#include <QtGui/QColor>
+#include <QtGui/QImage>
+
+QT_BEGIN_NAMESPACE
+
+class QSenseHatFb;
+
+class QSenseHatQuickLedMatrix : public QSenseHatFrameSyncItem
+{
+    Q_OBJECT
+    Q_PROPERTY(bool valid READ isValid CONSTANT)
+    Q_PROPERTY(int columns READ columns CONSTANT)
+    Q_PROPERTY(int rows READ rows CONSTANT)
+    Q_PROPERTY(bool lowLight READ lowLight WRITE setLowLight NOTIFY lowLightChanged)
+
+public:
+    explicit QSenseHatQuickLedMatrix(QQuickItem *parent = Q_NULLPTR);
+    ~QSenseHatQuickLedMatrix();
+
+    bool isValid() const;
+    int columns() const;
+    int rows() const;
+
+    bool lowLight() const { return m_lowLight; }
+    void setLowLight(bool enable);
+
+    Q_INVOKABLE QColor pixel(int x, int y) const;
+    Q_INVOKABLE void setPixel(int x, int y, const QColor &color);
+    Q_INVOKABLE void setPixels(const QVariantList &colors);
+    Q_INVOKABLE void fill(const QColor &color);
+    Q_INVOKABLE void clear();
+
+signals:
+    void lowLightChanged();
+
+protected:
+    void flush() Q_DECL_OVERRIDE;
+
+private:
+    QSenseHatFb *m_fb;
+    // Staging buffer, written to the framebuffer once per frame.
+    QImage m_pixels;
+    bool m_lowLight = false;
+};
+
+QT_END_NAMESPACE
+
+#endif
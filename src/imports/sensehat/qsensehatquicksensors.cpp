@@ -0,0 +1,137 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Sense HAT module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qsensehatquicksensors.h"
+#include <QtSenseHat/qsensehatsensors.h>
+
+QT_BEGIN_NAMESPACE
+
+QSenseHatQuickSensors::QSenseHatQuickSensors(QQuickItem *parent)
+    : QSenseHatFrameSyncItem(parent)
+{
+}
+
+QSenseHatQuickSensors::~QSenseHatQuickSensors()
+{
+    delete m_sensors;
+}
+
+void QSenseHatQuickSensors::setActive(bool active)
+{
+    if (m_active == active)
+        return;
+
+    m_active = active;
+    if (active && !m_sensors) {
+        m_sensors = new QSenseHatSensors;
+        // The values are picked up from m_sensors when flushing, here we only note what changed.
+        connect(m_sensors, &QSenseHatSensors::humidityChanged, this, [this] { changed(QSenseHatSensors::UpdateHumidity); });
+        connect(m_sensors, &QSenseHatSensors::pressureChanged, this, [this] { changed(QSenseHatSensors::UpdatePressure); });
+        connect(m_sensors, &QSenseHatSensors::temperatureChanged, this, [this] { changed(QSenseHatSensors::UpdateTemperature); });
+        connect(m_sensors, &QSenseHatSensors::gyroChanged, this, [this] { changed(QSenseHatSensors::UpdateGyro); });
+        connect(m_sensors, &QSenseHatSensors::accelerationChanged, this, [this] { changed(QSenseHatSensors::UpdateAcceleration); });
+        connect(m_sensors, &QSenseHatSensors::compassChanged, this, [this] { changed(QSenseHatSensors::UpdateCompass); });
+        connect(m_sensors, &QSenseHatSensors::orientationChanged, this, [this] { changed(QSenseHatSensors::UpdateOrientation); });
+    }
+    if (m_sensors)
+        m_sensors->setAutoPoll(active);
+
+    emit activeChanged();
+}
+
+void QSenseHatQuickSensors::changed(int flag)
+{
+    m_pending |= flag;
+    scheduleFlush();
+}
+
+void QSenseHatQuickSensors::flush()
+{
+    const int pending = m_pending;
+    m_pending = 0;
+
+    if (pending & QSenseHatSensors::UpdateHumidity)
+        emit humidityChanged();
+    if (pending & QSenseHatSensors::UpdatePressure)
+        emit pressureChanged();
+    if (pending & QSenseHatSensors::UpdateTemperature)
+        emit temperatureChanged();
+    if (pending & QSenseHatSensors::UpdateGyro)
+        emit gyroChanged();
+    if (pending & QSenseHatSensors::UpdateAcceleration)
+        emit accelerationChanged();
+    if (pending & QSenseHatSensors::UpdateCompass)
+        emit compassChanged();
+    if (pending & QSenseHatSensors::UpdateOrientation)
+        emit orientationChanged();
+}
+
+qreal QSenseHatQuickSensors::humidity() const
+{
+    return m_sensors ? m_sensors->humidity() : 0;
+}
+
+qreal QSenseHatQuickSensors::pressure() const
+{
+    return m_sensors ? m_sensors->pressure() : 0;
+}
+
+qreal QSenseHatQuickSensors::temperature() const
+{
+    return m_sensors ? m_sensors->temperature() : 0;
+}
+
+QVector3D QSenseHatQuickSensors::gyro() const
+{
+    return m_sensors ? m_sensors->gyro() : QVector3D();
+}
+
+QVector3D QSenseHatQuickSensors::acceleration() const
+{
+    return m_sensors ? m_sensors->acceleration() : QVector3D();
+}
+
+QVector3D QSenseHatQuickSensors::compass() const
+{
+    return m_sensors ? m_sensors->compass() : QVector3D();
+}
+
+QVector3D QSenseHatQuickSensors::orientation() const
+{
+    return m_sensors ? m_sensors->orientation() : QVector3D();
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,97 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Sense HAT module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QSENSEHATQUICKSENSORS_H
+#define QSENSEHATQUICKSENSORS_H
+
+#include "qsensehatframesyncitem.h"
+#include <QtGui/QVector3D>
+
+QT_BEGIN_NAMESPACE
+
+class QSenseHatSensors;
+
+class QSenseHatQuickSensors : public QSenseHatFrameSyncItem
+{
+    Q_OBJECT
+    Q_PROPERTY(bool active READ isActive WRITE setActive NOTIFY activeChanged)
+    Q_PROPERTY(qreal humidity READ humidity NOTIFY humidityChanged)
+    Q_PROPERTY(qreal pressure READ pressure NOTIFY pressureChanged)
+    Q_PROPERTY(qreal temperature READ temperature NOTIFY temperatureChanged)
+    Q_PROPERTY(QVector3D gyro READ gyro NOTIFY gyroChanged)
+    Q_PROPERTY(QVector3D acceleration READ acceleration NOTIFY accelerationChanged)
+    Q_PROPERTY(QVector3D compass READ compass NOTIFY compassChanged)
+    Q_PROPERTY(QVector3D orientation READ orientation NOTIFY orientationChanged)
+
+public:
+    explicit QSenseHatQuickSensors(QQuickItem *parent = Q_NULLPTR);
+    ~QSenseHatQuickSensors();
+
+    bool isActive() const { return m_active; }
+    void setActive(bool active);
+
+    qreal humidity() const;
+    qreal pressure() const;
+    qreal temperature() const;
+    QVector3D gyro() const;
+    QVector3D acceleration() const;
+    QVector3D compass() const;
+    QVector3D orientation() const;
+
+signals:
+    void activeChanged();
+    void humidityChanged();
+    void pressureChanged();
+    void temperatureChanged();
+    void gyroChanged();
+    void accelerationChanged();
+    void compassChanged();
+    void orientationChanged();
+
+protected:
+    void flush() Q_DECL_OVERRIDE;
+
+private:
+    void changed(int flag);
+
+    QSenseHatSensors *m_sensors = Q_NULLPTR;
+    bool m_active = false;
+    int m_pending = 0;
+};
+
+QT_END_NAMESPACE
+
+#endif
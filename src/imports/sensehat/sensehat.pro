@@ -0,0 +1,18 @@
+CXX_MODULE = sensehat
+TARGET = qtsensehatplugin
+TARGETPATH = SenseHat
+IMPORT_VERSION = 1.0
+
+QT += qml quick sensehat
+CONFIG += c++11
+
+HEADERS += qsensehatframesyncitem.h \
+           qsensehatquicksensors.h \
+           qsensehatquickledmatrix.h
+
+SOURCES += plugin.cpp \
+           qsensehatframesyncitem.cpp \
+           qsensehatquicksensors.cpp \
+           qsensehatquickledmatrix.cpp
+
+load(qml_plugin)
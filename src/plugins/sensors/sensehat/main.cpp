@@ -0,0 +1,88 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Sense HAT module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qsensehatsensorbackend.h"
+#include <QtSensors/qsensorplugin.h>
+#include <QtSensors/qsensormanager.h>
+#include <QtSensors/QAccelerometer>
+#include <QtSensors/QGyroscope>
+#include <QtSensors/QMagnetometer>
+#include <QtSensors/QPressureSensor>
+#if QT_VERSION >= QT_VERSION_CHECK(5, 9, 0)
+#include <QtSensors/QHumiditySensor>
+#endif
+
+QT_BEGIN_NAMESPACE
+
+class QSenseHatSensorPlugin : public QObject, public QSensorPluginInterface, public QSensorBackendFactory
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID "com.qt-project.Qt.QSensorPluginInterface/1.0" FILE "plugin.json")
+    Q_INTERFACES(QSensorPluginInterface)
+
+public:
+    void registerSensors() Q_DECL_OVERRIDE
+    {
+        QSensorManager::registerBackend(QAccelerometer::type, QSenseHatAccelerometer::id, this);
+        QSensorManager::registerBackend(QGyroscope::type, QSenseHatGyroscope::id, this);
+        QSensorManager::registerBackend(QMagnetometer::type, QSenseHatMagnetometer::id, this);
+        QSensorManager::registerBackend(QPressureSensor::type, QSenseHatPressureSensor::id, this);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 9, 0)
+        QSensorManager::registerBackend(QHumiditySensor::type, QSenseHatHumiditySensor::id, this);
+#endif
+    }
+
+    QSensorBackend *createBackend(QSensor *sensor) Q_DECL_OVERRIDE
+    {
+        if (sensor->identifier() == QSenseHatAccelerometer::id)
+            return new QSenseHatAccelerometer(sensor);
+        if (sensor->identifier() == QSenseHatGyroscope::id)
+            return new QSenseHatGyroscope(sensor);
+        if (sensor->identifier() == QSenseHatMagnetometer::id)
+            return new QSenseHatMagnetometer(sensor);
+        if (sensor->identifier() == QSenseHatPressureSensor::id)
+            return new QSenseHatPressureSensor(sensor);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 9, 0)
+        if (sensor->identifier() == QSenseHatHumiditySensor::id)
+            return new QSenseHatHumiditySensor(sensor);
+#endif
+        return Q_NULLPTR;
+    }
+};
+
+QT_END_NAMESPACE
+
+#include "main.moc"
@@ -0,0 +1,377 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Sense HAT module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qsensehatsensorbackend.h"
+#include <QtCore/QPointer>
+#include <QtCore/QVarLengthArray>
+#include <QtCore/qmath.h>
+#include <time.h>
+
+QT_BEGIN_NAMESPACE
+
+static const qreal STANDARD_GRAVITY = 9.80665;
+
+// Output data rate limits of the HTS221 and LPS25H, the IMU is limited by its poll interval.
+static const int HUMIDITY_MAX_RATE = 12;
+static const int PRESSURE_MAX_RATE = 25;
+
+static inline quint64 monotonicUSecs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return quint64(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+static bool sameValues(const QSenseHatSensorSample &a, const QSenseHatSensorSample &b,
+                       QSenseHatSensorCore::Channels channels)
+{
+    if ((channels & QSenseHatSensorCore::Humidity) && a.humidity != b.humidity)
+        return false;
+    if ((channels & QSenseHatSensorCore::Pressure) && a.pressure != b.pressure)
+        return false;
+    if ((channels & QSenseHatSensorCore::Temperature) && a.temperature != b.temperature)
+        return false;
+    if ((channels & QSenseHatSensorCore::Gyro) && memcmp(a.gyro, b.gyro, sizeof(a.gyro)))
+        return false;
+    if ((channels & QSenseHatSensorCore::Acceleration) && memcmp(a.acceleration, b.acceleration, sizeof(a.acceleration)))
+        return false;
+    if ((channels & QSenseHatSensorCore::Compass) && memcmp(a.compass, b.compass, sizeof(a.compass)))
+        return false;
+    if ((channels & QSenseHatSensorCore::Orientation) && memcmp(a.orientation, b.orientation, sizeof(a.orientation)))
+        return false;
+    return true;
+}
+
+QSenseHatSensorHub *QSenseHatSensorHub::s_instance = Q_NULLPTR;
+
+QSenseHatSensorHub::QSenseHatSensorHub()
+{
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &QSenseHatSensorHub::poll);
+}
+
+QSenseHatSensorHub *QSenseHatSensorHub::acquire()
+{
+    if (!s_instance)
+        s_instance = new QSenseHatSensorHub;
+    ++s_instance->m_refCount;
+    return s_instance;
+}
+
+void QSenseHatSensorHub::release()
+{
+    if (!--m_refCount) {
+        s_instance = Q_NULLPTR;
+        delete this;
+    }
+}
+
+void QSenseHatSensorHub::start(QSenseHatSensorBackend *backend)
+{
+    stop(backend);
+    Client client;
+    client.backend = backend;
+    client.interval = quint64(backend->interval()) * 1000;
+    client.due = monotonicUSecs();
+    m_clients.append(client);
+    reschedule();
+}
+
+void QSenseHatSensorHub::stop(QSenseHatSensorBackend *backend)
+{
+    for (int i = 0; i < m_clients.count(); ++i) {
+        if (m_clients.at(i).backend == backend) {
+            m_clients.remove(i);
+            break;
+        }
+    }
+    reschedule();
+}
+
+void QSenseHatSensorHub::reschedule()
+{
+    if (m_clients.isEmpty()) {
+        m_timer.stop();
+        return;
+    }
+
+    quint64 interval = m_clients.first().interval;
+    for (const Client &client : m_clients)
+        interval = qMin(interval, client.interval);
+    m_timer.setInterval(int(interval / 1000));
+    if (!m_timer.isActive())
+        m_timer.start();
+}
+
+void QSenseHatSensorHub::poll()
+{
+    // Allow for timer jitter, otherwise sensors at the fastest rate would skip every other tick.
+    const quint64 slack = quint64(m_timer.interval()) * 500;
+    const quint64 now = monotonicUSecs();
+
+    QSenseHatSensorCore::Channels due = 0;
+    for (const Client &client : m_clients) {
+        if (now + slack >= client.due)
+            due |= client.backend->channels();
+    }
+    if (!due)
+        return;
+
+    m_core.read(m_sample, due);
+
+    QVarLengthArray<QSenseHatSensorBackend *, 8> receivers;
+    for (int i = 0; i < m_clients.count(); ++i) {
+        Client &client(m_clients[i]);
+        if (now + slack < client.due)
+            continue;
+        client.due += client.interval;
+        if (client.due < now)
+            client.due = now + client.interval;
+        receivers.append(client.backend);
+    }
+
+    // Reading slots may stop or destroy sensors, so look each receiver up again.
+    for (QSenseHatSensorBackend *backend : receivers) {
+        for (const Client &client : m_clients) {
+            if (client.backend == backend) {
+                backend->addSample(m_sample);
+                break;
+            }
+        }
+    }
+}
+
+QSenseHatSensorBackend::QSenseHatSensorBackend(QSenseHatSensorCore::Channels channels, QSensor *sensor)
+    : QSensorBackend(sensor),
+      m_channels(channels),
+      m_hub(QSenseHatSensorHub::acquire())
+{
+}
+
+QSenseHatSensorBackend::~QSenseHatSensorBackend()
+{
+    m_hub->stop(this);
+    m_hub->release();
+}
+
+int QSenseHatSensorBackend::pollInterval() const
+{
+    return m_hub->pollInterval();
+}
+
+void QSenseHatSensorBackend::init(QSensorReading *reading, int maxRate, int defaultRate)
+{
+    m_sensorReading = reading;
+    m_maxRate = maxRate;
+    m_defaultRate = defaultRate;
+    addDataRate(1, maxRate);
+    // Up to one second worth of readings; batching a tenth of that already saves
+    // most of the per-reading overhead.
+    const int maxBufferSize = qMax(1, maxRate);
+    sensor()->setMaxBufferSize(maxBufferSize);
+    sensor()->setEfficientBufferSize(qMin(maxBufferSize, qMax(2, maxRate / 10)));
+}
+
+int QSenseHatSensorBackend::interval() const
+{
+    int rate = sensor()->dataRate();
+    if (rate <= 0)
+        rate = m_defaultRate;
+    return 1000 / qBound(1, rate, m_maxRate);
+}
+
+void QSenseHatSensorBackend::start()
+{
+    m_bufferSize = qBound(1, sensor()->bufferSize(), sensor()->maxBufferSize());
+    m_buffer.clear();
+    m_buffer.reserve(m_bufferSize);
+    m_hasLast = false;
+    ++m_generation;
+    m_hub->start(this);
+}
+
+void QSenseHatSensorBackend::stop()
+{
+    m_hub->stop(this);
+    flush();
+    ++m_generation;
+}
+
+bool QSenseHatSensorBackend::isFeatureSupported(QSensor::Feature feature) const
+{
+    switch (feature) {
+    case QSensor::Buffering:
+    case QSensor::SkipDuplicates:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void QSenseHatSensorBackend::addSample(const QSenseHatSensorSample &sample)
+{
+    if ((sample.valid & m_channels) != uint(m_channels))
+        return;
+
+    if (sensor()->skipDuplicates() && m_hasLast && sameValues(sample, m_last, m_channels))
+        return;
+    m_last = sample;
+    m_hasLast = true;
+
+    m_buffer.append(sample);
+    if (m_buffer.count() >= m_bufferSize)
+        flush();
+}
+
+void QSenseHatSensorBackend::flush()
+{
+    // The whole batch is delivered back to back, each with its own timestamp.
+    // Reading slots may stop, restart or destroy the sensor, so work on a detached
+    // copy and give up as soon as that happens.
+    QVector<QSenseHatSensorSample> batch;
+    batch.swap(m_buffer);
+    const uint generation = m_generation;
+    QPointer<QSenseHatSensorBackend> guard(this);
+    for (int i = 0; i < batch.count(); ++i) {
+        const QSenseHatSensorSample &sample(batch.at(i));
+        m_sensorReading->setTimestamp(sample.timestamp);
+        setReadingValues(sample);
+        newReadingAvailable();
+        if (!guard || m_generation != generation)
+            return;
+    }
+
+    // Keep the reserved capacity around for the next batch.
+    batch.resize(0);
+    if (m_buffer.isEmpty())
+        m_buffer.swap(batch);
+}
+
+const char *QSenseHatAccelerometer::id = "sensehat.accelerometer";
+
+QSenseHatAccelerometer::QSenseHatAccelerometer(QSensor *sensor)
+    : QSenseHatSensorBackend(QSenseHatSensorCore::Acceleration, sensor)
+{
+    setReading<QAccelerometerReading>(&m_reading);
+    const int maxRate = 1000 / pollInterval();
+    init(&m_reading, maxRate, maxRate);
+    addOutputRange(-8 * STANDARD_GRAVITY, 8 * STANDARD_GRAVITY, 0.01);
+    setDescription(QStringLiteral("Sense HAT accelerometer"));
+}
+
+void QSenseHatAccelerometer::setReadingValues(const QSenseHatSensorSample &sample)
+{
+    // RTIMULib reports g.
+    m_reading.setX(sample.acceleration[0] * STANDARD_GRAVITY);
+    m_reading.setY(sample.acceleration[1] * STANDARD_GRAVITY);
+    m_reading.setZ(sample.acceleration[2] * STANDARD_GRAVITY);
+}
+
+const char *QSenseHatGyroscope::id = "sensehat.gyroscope";
+
+QSenseHatGyroscope::QSenseHatGyroscope(QSensor *sensor)
+    : QSenseHatSensorBackend(QSenseHatSensorCore::Gyro, sensor)
+{
+    setReading<QGyroscopeReading>(&m_reading);
+    const int maxRate = 1000 / pollInterval();
+    init(&m_reading, maxRate, maxRate);
+    setDescription(QStringLiteral("Sense HAT gyroscope"));
+}
+
+void QSenseHatGyroscope::setReadingValues(const QSenseHatSensorSample &sample)
+{
+    // RTIMULib reports radians per second.
+    m_reading.setX(qRadiansToDegrees(sample.gyro[0]));
+    m_reading.setY(qRadiansToDegrees(sample.gyro[1]));
+    m_reading.setZ(qRadiansToDegrees(sample.gyro[2]));
+}
+
+const char *QSenseHatMagnetometer::id = "sensehat.magnetometer";
+
+QSenseHatMagnetometer::QSenseHatMagnetometer(QSensor *sensor)
+    : QSenseHatSensorBackend(QSenseHatSensorCore::Compass, sensor)
+{
+    setReading<QMagnetometerReading>(&m_reading);
+    const int maxRate = 1000 / pollInterval();
+    init(&m_reading, maxRate, maxRate);
+    setDescription(QStringLiteral("Sense HAT magnetometer"));
+}
+
+void QSenseHatMagnetometer::setReadingValues(const QSenseHatSensorSample &sample)
+{
+    // RTIMULib reports calibrated values in microtesla.
+    m_reading.setX(sample.compass[0] * 1e-6);
+    m_reading.setY(sample.compass[1] * 1e-6);
+    m_reading.setZ(sample.compass[2] * 1e-6);
+    m_reading.setCalibrationLevel(1);
+}
+
+const char *QSenseHatPressureSensor::id = "sensehat.pressure";
+
+QSenseHatPressureSensor::QSenseHatPressureSensor(QSensor *sensor)
+    : QSenseHatSensorBackend(QSenseHatSensorCore::Pressure, sensor)
+{
+    setReading<QPressureReading>(&m_reading);
+    init(&m_reading, PRESSURE_MAX_RATE, 1);
+    addOutputRange(26000, 126000, 0.1);
+    setDescription(QStringLiteral("Sense HAT LPS25H pressure sensor"));
+}
+
+void QSenseHatPressureSensor::setReadingValues(const QSenseHatSensorSample &sample)
+{
+    // RTIMULib reports hPa.
+    m_reading.setPressure(sample.pressure * 100);
+}
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 9, 0)
+const char *QSenseHatHumiditySensor::id = "sensehat.humidity";
+
+QSenseHatHumiditySensor::QSenseHatHumiditySensor(QSensor *sensor)
+    : QSenseHatSensorBackend(QSenseHatSensorCore::Humidity, sensor)
+{
+    setReading<QHumidityReading>(&m_reading);
+    init(&m_reading, HUMIDITY_MAX_RATE, 1);
+    addOutputRange(0, 100, 0.1);
+    setDescription(QStringLiteral("Sense HAT HTS221 humidity sensor"));
+}
+
+void QSenseHatHumiditySensor::setReadingValues(const QSenseHatSensorSample &sample)
+{
+    m_reading.setRelativeHumidity(sample.humidity);
+}
+#endif
+
+QT_END_NAMESPACE
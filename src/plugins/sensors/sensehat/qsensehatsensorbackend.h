@@ -0,0 +1,193 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Sense HAT module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QSENSEHATSENSORBACKEND_H
+#define QSENSEHATSENSORBACKEND_H
+
+#include <QtSenseHat/qsensehatsensorcore.h>
+#include <QtSensors/qsensorbackend.h>
+#include <QtSensors/QAccelerometerReading>
+#include <QtSensors/QGyroscopeReading>
+#include <QtSensors/QMagnetometerReading>
+#include <QtSensors/QPressureReading>
+#if QT_VERSION >= QT_VERSION_CHECK(5, 9, 0)
+#include <QtSensors/QHumidityReading>
+#endif
+#include <QtCore/QTimer>
+#include <QtCore/QVector>
+
+QT_BEGIN_NAMESPACE
+
+class QSenseHatSensorHub;
+
+class QSenseHatSensorBackend : public QSensorBackend
+{
+public:
+    QSenseHatSensorBackend(QSenseHatSensorCore::Channels channels, QSensor *sensor);
+    ~QSenseHatSensorBackend();
+
+    void start() Q_DECL_OVERRIDE;
+    void stop() Q_DECL_OVERRIDE;
+    bool isFeatureSupported(QSensor::Feature feature) const Q_DECL_OVERRIDE;
+
+    QSenseHatSensorCore::Channels channels() const { return m_channels; }
+    int interval() const;
+    void addSample(const QSenseHatSensorSample &sample);
+
+protected:
+    int pollInterval() const;
+    void init(QSensorReading *reading, int maxRate, int defaultRate);
+    virtual void setReadingValues(const QSenseHatSensorSample &sample) = 0;
+
+private:
+    void flush();
+
+    QSenseHatSensorCore::Channels m_channels;
+    QSenseHatSensorHub *m_hub;
+    QSensorReading *m_sensorReading = Q_NULLPTR;
+    int m_maxRate = 1;
+    int m_defaultRate = 1;
+    QVector<QSenseHatSensorSample> m_buffer;
+    int m_bufferSize = 1;
+    QSenseHatSensorSample m_last;
+    bool m_hasLast = false;
+    uint m_generation = 0; // bumped by start() and stop()
+};
+
+class QSenseHatAccelerometer : public QSenseHatSensorBackend
+{
+public:
+    static const char *id;
+    QSenseHatAccelerometer(QSensor *sensor);
+
+protected:
+    void setReadingValues(const QSenseHatSensorSample &sample) Q_DECL_OVERRIDE;
+
+private:
+    QAccelerometerReading m_reading;
+};
+
+class QSenseHatGyroscope : public QSenseHatSensorBackend
+{
+public:
+    static const char *id;
+    QSenseHatGyroscope(QSensor *sensor);
+
+protected:
+    void setReadingValues(const QSenseHatSensorSample &sample) Q_DECL_OVERRIDE;
+
+private:
+    QGyroscopeReading m_reading;
+};
+
+class QSenseHatMagnetometer : public QSenseHatSensorBackend
+{
+public:
+    static const char *id;
+    QSenseHatMagnetometer(QSensor *sensor);
+
+protected:
+    void setReadingValues(const QSenseHatSensorSample &sample) Q_DECL_OVERRIDE;
+
+private:
+    QMagnetometerReading m_reading;
+};
+
+class QSenseHatPressureSensor : public QSenseHatSensorBackend
+{
+public:
+    static const char *id;
+    QSenseHatPressureSensor(QSensor *sensor);
+
+protected:
+    void setReadingValues(const QSenseHatSensorSample &sample) Q_DECL_OVERRIDE;
+
+private:
+    QPressureReading m_reading;
+};
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 9, 0)
+class QSenseHatHumiditySensor : public QSenseHatSensorBackend
+{
+public:
+    static const char *id;
+    QSenseHatHumiditySensor(QSensor *sensor);
+
+protected:
+    void setReadingValues(const QSenseHatSensorSample &sample) Q_DECL_OVERRIDE;
+
+private:
+    QHumidityReading m_reading;
+};
+#endif
+
+// Shares one sensor core between all backends. Every sensor gets its own
+// rate, a single timer runs at the fastest one and each tick reads only the
+// channels of the sensors that are due.
+class QSenseHatSensorHub : public QObject
+{
+public:
+    static QSenseHatSensorHub *acquire();
+    void release();
+
+    int pollInterval() const { return m_core.pollInterval(); }
+
+    void start(QSenseHatSensorBackend *backend);
+    void stop(QSenseHatSensorBackend *backend);
+
+private:
+    QSenseHatSensorHub();
+
+    void poll();
+    void reschedule();
+
+    struct Client {
+        QSenseHatSensorBackend *backend;
+        quint64 interval;
+        quint64 due;
+    };
+
+    QSenseHatSensorCore m_core;
+    QSenseHatSensorSample m_sample;
+    QVector<Client> m_clients;
+    QTimer m_timer;
+    int m_refCount = 0;
+    static QSenseHatSensorHub *s_instance;
+};
+
+QT_END_NAMESPACE
+
+#endif
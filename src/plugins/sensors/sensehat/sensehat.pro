@@ -0,0 +1,14 @@
+TARGET = qtsensors_sensehat
+QT = core sensors sensehat
+CONFIG += c++11
+
+HEADERS += qsensehatsensorbackend.h
+
+SOURCES += qsensehatsensorbackend.cpp \
+           main.cpp
+
+OTHER_FILES = plugin.json
+
+PLUGIN_TYPE = sensors
+PLUGIN_CLASS_NAME = QSenseHatSensorPlugin
+load(qt_plugin)
@@ -0,0 +1,396 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Sense HAT module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qsensehatcompasscalibrator_p.h"
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QLoggingCategory>
+#include <RTIMULib.h>
+#include <cmath>
+#include <limits>
+#include <locale.h>
+
+QT_BEGIN_NAMESPACE
+
+static const int POLL_INTERVAL_MS = 50;
+static const double FORGETTING_FACTOR = 0.998;
+static const double INITIAL_COVARIANCE = 100;
+static const double MAX_COVARIANCE_TRACE = 1e4; // stop forgetting when nothing new comes in
+static const double MIN_SAMPLE_DISTANCE = 0.05; // relative to the field strength
+static const int MIN_SAMPLES = 100;
+static const double MIN_COVERAGE = 1; // span seen on each axis, in radii
+static const double MIN_CHANGE = 0.01; // relative to the mean radius
+static const int SAVE_INTERVAL_MS = 60000;
+
+Q_DECLARE_LOGGING_CATEGORY(qLcSH)
+
+// Like CLocale in the sensor core, but only for the calling thread, since the
+// acquisition thread may be using the process locale at the same time.
+class ThreadCLocale
+{
+public:
+    ThreadCLocale() : loc(newlocale(LC_ALL_MASK, "C", 0)), oldLoc(loc ? uselocale(loc) : 0) { }
+    ~ThreadCLocale() {
+        if (loc) {
+            uselocale(oldLoc);
+            freelocale(loc);
+        }
+    }
+private:
+    locale_t loc;
+    locale_t oldLoc;
+};
+
+QSenseHatCompassCalibrator::QSenseHatCompassCalibrator(const QString &settingsDir)
+    : settingsDir(settingsDir), queueHead(0), queueTail(0), quit(0), calibrationState(NoCalibration)
+{
+    reset();
+}
+
+QSenseHatCompassCalibrator::~QSenseHatCompassCalibrator()
+{
+    quit.storeRelease(1);
+    wait();
+}
+
+void QSenseHatCompassCalibrator::addSample(const float *raw)
+{
+    const uint head = queueHead.load();
+    if (head - queueTail.loadAcquire() >= QueueSize)
+        return; // the worker is behind, dropping samples does not matter
+    float *slot = queue[head % QueueSize];
+    slot[0] = raw[0];
+    slot[1] = raw[1];
+    slot[2] = raw[2];
+    queueHead.storeRelease(head + 1);
+}
+
+bool QSenseHatCompassCalibrator::takeCalibration(QSenseHatCompassCalibration *calibration)
+{
+    if (!calibrationState.testAndSetAcquire(CalibrationReady, TakingCalibration))
+        return false;
+    *calibration = handedOver;
+    calibrationState.storeRelease(NoCalibration);
+    return true;
+}
+
+void QSenseHatCompassCalibrator::reset()
+{
+    // Start from a sphere through the first sample, centered on the origin.
+    scale = 0;
+    for (int i = 0; i < Parameters; ++i) {
+        theta[i] = i < 3 ? 1 : 0;
+        for (int j = 0; j < Parameters; ++j)
+            P[i][j] = i == j ? INITIAL_COVARIANCE : 0;
+    }
+    for (int i = 0; i < 3; ++i) {
+        last[i] = 0;
+        lo[i] = std::numeric_limits<double>::max();
+        hi[i] = -std::numeric_limits<double>::max();
+    }
+    count = 0;
+}
+
+// One recursive least squares step for the quadric
+// a x^2 + b y^2 + c z^2 + 2 d xy + 2 e xz + 2 f yz + 2 g x + 2 h y + 2 i z = 1.
+// Returns false when the sample is too close to the previous one to add anything,
+// so that a device lying still does not wash out what was learned before.
+bool QSenseHatCompassCalibrator::fit(const float *raw)
+{
+    if (scale == 0) {
+        const double norm = std::sqrt(double(raw[0]) * raw[0] + double(raw[1]) * raw[1] + double(raw[2]) * raw[2]);
+        if (norm <= 0)
+            return false;
+        scale = 1 / norm; // keeps the normal equations well conditioned
+    }
+
+    double v[3];
+    double distance = 0;
+    for (int i = 0; i < 3; ++i) {
+        v[i] = raw[i] * scale;
+        distance += (v[i] - last[i]) * (v[i] - last[i]);
+    }
+    if (count && distance < MIN_SAMPLE_DISTANCE * MIN_SAMPLE_DISTANCE)
+        return false;
+
+    for (int i = 0; i < 3; ++i) {
+        last[i] = v[i];
+        lo[i] = qMin(lo[i], v[i]);
+        hi[i] = qMax(hi[i], v[i]);
+    }
+    ++count;
+
+    const double phi[Parameters] = { v[0] * v[0], v[1] * v[1], v[2] * v[2],
+                                     2 * v[0] * v[1], 2 * v[0] * v[2], 2 * v[1] * v[2],
+                                     2 * v[0], 2 * v[1], 2 * v[2] };
+    double Pphi[Parameters];
+    double denom = 0;
+    double error = 1;
+    double trace = 0;
+    for (int i = 0; i < Parameters; ++i) {
+        Pphi[i] = 0;
+        for (int j = 0; j < Parameters; ++j)
+            Pphi[i] += P[i][j] * phi[j];
+        error -= phi[i] * theta[i];
+        trace += P[i][i];
+    }
+    const double lambda = trace < MAX_COVARIANCE_TRACE ? FORGETTING_FACTOR : 1;
+    for (int i = 0; i < Parameters; ++i)
+        denom += phi[i] * Pphi[i];
+    denom += lambda;
+
+    for (int i = 0; i < Parameters; ++i) {
+        theta[i] += Pphi[i] / denom * error;
+        for (int j = 0; j < Parameters; ++j)
+            P[i][j] = (P[i][j] - Pphi[i] * Pphi[j] / denom) / lambda;
+    }
+    return true;
+}
+
+// Eigenvalues d and eigenvectors (the columns of v) of the symmetric matrix a, by Jacobi rotations.
+static void symmetricEigen(const double a[3][3], double *d, double v[3][3])
+{
+    double m[3][3];
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            m[i][j] = a[i][j];
+            v[i][j] = i == j ? 1 : 0;
+        }
+    }
+
+    for (int sweep = 0; sweep < 50; ++sweep) {
+        const double off = m[0][1] * m[0][1] + m[0][2] * m[0][2] + m[1][2] * m[1][2];
+        const double diag = m[0][0] * m[0][0] + m[1][1] * m[1][1] + m[2][2] * m[2][2];
+        if (off <= 1e-24 * diag)
+            break;
+        for (int p = 0; p < 2; ++p) {
+            for (int q = p + 1; q < 3; ++q) {
+                if (m[p][q] == 0)
+                    continue;
+                const double h = (m[q][q] - m[p][p]) / (2 * m[p][q]);
+                const double t = (h >= 0 ? 1 : -1) / (std::fabs(h) + std::sqrt(h * h + 1));
+                const double c = 1 / std::sqrt(t * t + 1);
+                const double s = t * c;
+                for (int k = 0; k < 3; ++k) {
+                    const double kp = m[k][p];
+                    const double kq = m[k][q];
+                    m[k][p] = c * kp - s * kq;
+                    m[k][q] = s * kp + c * kq;
+                }
+                for (int k = 0; k < 3; ++k) {
+                    const double pk = m[p][k];
+                    const double qk = m[q][k];
+                    m[p][k] = c * pk - s * qk;
+                    m[q][k] = s * pk + c * qk;
+                }
+                for (int k = 0; k < 3; ++k) {
+                    const double kp = v[k][p];
+                    const double kq = v[k][q];
+                    v[k][p] = c * kp - s * kq;
+                    v[k][q] = s * kp + c * kq;
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < 3; ++i)
+        d[i] = m[i][i];
+}
+
+// Converts the ellipsoid to what RTIMULib applies, in raw units. The min/max values take out
+// the hard iron offset and the extent along each axis. The ellipsoid correction then removes
+// the remaining, rotated distortion and scales to the mean radius, which is the field strength.
+bool QSenseHatCompassCalibrator::solve(QSenseHatCompassCalibration *calibration) const
+{
+    if (count < MIN_SAMPLES)
+        return false;
+
+    // x^T M x + 2 u^T x = 1
+    const double M[3][3] = { { theta[0], theta[3], theta[4] },
+                             { theta[3], theta[1], theta[5] },
+                             { theta[4], theta[5], theta[2] } };
+    const double *u = theta + 6;
+    double eigenvalues[3];
+    double V[3][3];
+    symmetricEigen(M, eigenvalues, V);
+    for (int i = 0; i < 3; ++i) {
+        if (eigenvalues[i] == 0)
+            return false;
+    }
+
+    double Minv[3][3];
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            Minv[i][j] = 0;
+            for (int k = 0; k < 3; ++k)
+                Minv[i][j] += V[i][k] * V[j][k] / eigenvalues[k];
+        }
+    }
+
+    // With center c = -M^-1 u, the quadric is (x - c)^T M (x - c) = g. When the origin lies
+    // outside the ellipsoid, M and g are both negative.
+    double center[3];
+    double g = 1;
+    for (int i = 0; i < 3; ++i) {
+        center[i] = 0;
+        for (int j = 0; j < 3; ++j)
+            center[i] -= Minv[i][j] * u[j];
+    }
+    for (int i = 0; i < 3; ++i)
+        g -= center[i] * u[i];
+    for (int i = 0; i < 3; ++i) {
+        if (g == 0 || eigenvalues[i] / g <= 0)
+            return false; // not an ellipsoid (yet)
+    }
+
+    double radius[3];
+    double maxRadius = 0;
+    for (int i = 0; i < 3; ++i) {
+        radius[i] = std::sqrt(g * Minv[i][i]);
+        if (hi[i] - lo[i] < MIN_COVERAGE * radius[i])
+            return false; // not rotated around enough to trust this axis
+        maxRadius = qMax(maxRadius, radius[i]);
+    }
+
+    // The semi-axes are sqrt(g / eigenvalue); their geometric mean keeps the volume.
+    double meanRadius = 1;
+    for (int i = 0; i < 3; ++i)
+        meanRadius *= std::sqrt(g / eigenvalues[i]);
+    meanRadius = std::cbrt(meanRadius);
+
+    for (int i = 0; i < 3; ++i) {
+        calibration->min[i] = (center[i] - radius[i]) / scale;
+        calibration->max[i] = (center[i] + radius[i]) / scale;
+        calibration->ellipsoidOffset[i] = 0; // already centered by min/max
+        // RTIMULib has multiplied column i by maxRadius / radius[i], take that out again.
+        for (int j = 0; j < 3; ++j) {
+            double w = 0;
+            for (int k = 0; k < 3; ++k)
+                w += V[i][k] * V[j][k] * std::sqrt(eigenvalues[k] / g);
+            calibration->ellipsoidCorr[i][j] = w * meanRadius * radius[j] / maxRadius;
+        }
+    }
+    return true;
+}
+
+void QSenseHatCompassCalibrator::save(const QSenseHatCompassCalibration &calibration)
+{
+    if (settingsDir.isEmpty())
+        return;
+
+    ThreadCLocale c; // to avoid decimal separator trouble in the ini file
+    const QByteArray dirName = QFile::encodeName(settingsDir);
+    RTIMUSettings settings(dirName.constData(), "RTIMULib");
+    settings.m_compassCalValid = true;
+    settings.m_compassCalMin = RTVector3(calibration.min[0], calibration.min[1], calibration.min[2]);
+    settings.m_compassCalMax = RTVector3(calibration.max[0], calibration.max[1], calibration.max[2]);
+    settings.m_compassCalEllipsoidValid = true;
+    settings.m_compassCalEllipsoidOffset = RTVector3(calibration.ellipsoidOffset[0],
+                                                     calibration.ellipsoidOffset[1],
+                                                     calibration.ellipsoidOffset[2]);
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j)
+            settings.m_compassCalEllipsoidCorr[i][j] = calibration.ellipsoidCorr[i][j];
+    }
+    if (settings.saveSettings())
+        qCDebug(qLcSH, "Saved compass calibration to %s", dirName.constData());
+    else
+        qWarning("Failed to save compass calibration to %s", dirName.constData());
+}
+
+void QSenseHatCompassCalibrator::run()
+{
+    QSenseHatCompassCalibration published;
+    bool hasPublished = false;
+    bool pending = false; // significant, but not handed over yet
+    bool unsaved = false;
+    QElapsedTimer sinceSave;
+    sinceSave.start();
+
+    while (!quit.loadAcquire()) {
+        msleep(POLL_INTERVAL_MS);
+
+        bool changed = false;
+        const uint head = queueHead.loadAcquire();
+        uint tail = queueTail.load();
+        for (; tail != head; ++tail)
+            changed |= fit(queue[tail % QueueSize]);
+        queueTail.storeRelease(tail);
+
+        QSenseHatCompassCalibration fitted;
+        if (changed && solve(&fitted)) {
+            double radius = 0;
+            for (int i = 0; i < 3; ++i)
+                radius += (fitted.max[i] - fitted.min[i]) / 6;
+            bool significant = !hasPublished;
+            for (int i = 0; i < 3 && !significant; ++i) {
+                significant = std::fabs(fitted.min[i] - published.min[i]) > MIN_CHANGE * radius
+                        || std::fabs(fitted.max[i] - published.max[i]) > MIN_CHANGE * radius;
+                for (int j = 0; j < 3 && !significant; ++j)
+                    significant = std::fabs(fitted.ellipsoidCorr[i][j] - published.ellipsoidCorr[i][j]) > MIN_CHANGE;
+            }
+
+            if (significant) {
+                hasPublished = true;
+                pending = true;
+                unsaved = true;
+                published = fitted;
+                qCDebug(qLcSH, "Compass calibration min %f %f %f max %f %f %f",
+                        fitted.min[0], fitted.min[1], fitted.min[2], fitted.max[0], fitted.max[1], fitted.max[2]);
+            }
+        }
+
+        // Replaces an older result the acquisition thread has not picked up yet. Once the
+        // state is NoCalibration, takeCalibration() cannot touch handedOver.
+        if (pending && (calibrationState.testAndSetAcquire(CalibrationReady, NoCalibration)
+                        || calibrationState.loadAcquire() == NoCalibration)) {
+            handedOver = published;
+            calibrationState.storeRelease(CalibrationReady);
+            pending = false;
+        }
+
+        if (unsaved && sinceSave.hasExpired(SAVE_INTERVAL_MS)) {
+            save(published);
+            unsaved = false;
+            sinceSave.restart();
+        }
+    }
+
+    if (unsaved)
+        save(published);
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,117 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Sense HAT module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QSENSEHATCOMPASSCALIBRATOR_P_H
+#define QSENSEHATCOMPASSCALIBRATOR_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtSenseHat/qsenseglobal.h>
+#include <QtCore/QAtomicInteger>
+#include <QtCore/QString>
+#include <QtCore/QThread>
+
+QT_BEGIN_NAMESPACE
+
+// A compass calibration in the form RTIMULib applies it: first the min/max values
+// (hard iron offset and per-axis scale), then (v - ellipsoidOffset) * ellipsoidCorr.
+struct QSenseHatCompassCalibration
+{
+    float min[3];
+    float max[3];
+    float ellipsoidOffset[3];
+    float ellipsoidCorr[3][3];
+};
+
+// Fits a general ellipsoid (hard iron offset and soft iron distortion) to the raw
+// magnetometer readings with recursive least squares, on its own thread.
+class QSenseHatCompassCalibrator : public QThread
+{
+public:
+    // The fitted calibration is saved to RTIMULib.ini in settingsDir, unless it is empty.
+    explicit QSenseHatCompassCalibrator(const QString &settingsDir);
+    ~QSenseHatCompassCalibrator();
+
+    // Both are called from the acquisition thread. They take no locks, the worker
+    // polls for new samples instead of being woken up.
+    void addSample(const float *raw);
+    bool takeCalibration(QSenseHatCompassCalibration *calibration);
+
+protected:
+    void run() Q_DECL_OVERRIDE;
+
+private:
+    void reset();
+    bool fit(const float *raw);
+    bool solve(QSenseHatCompassCalibration *calibration) const;
+    void save(const QSenseHatCompassCalibration &calibration);
+
+    enum { QueueSize = 64, Parameters = 9 };
+    enum CalibrationState { NoCalibration, CalibrationReady, TakingCalibration };
+
+    QString settingsDir;
+    // Single producer, single consumer ring buffer; the indices only ever grow.
+    float queue[QueueSize][3];
+    QAtomicInteger<uint> queueHead; // written by addSample()
+    QAtomicInteger<uint> queueTail; // written by the worker
+    QAtomicInt quit;
+    // The worker only writes handedOver in NoCalibration state, takeCalibration() only reads
+    // it in TakingCalibration state.
+    QAtomicInt calibrationState;
+    QSenseHatCompassCalibration handedOver;
+
+    // Only touched by the worker.
+    double scale;
+    double theta[Parameters];
+    double P[Parameters][Parameters];
+    double last[3];
+    double lo[3];
+    double hi[3];
+    int count;
+};
+
+QT_END_NAMESPACE
+
+#endif
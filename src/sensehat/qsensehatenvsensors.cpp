@@ -0,0 +1,197 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Sense HAT module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qsensehatenvsensors_p.h"
+#include "qsensehati2c_p.h"
+#include <unistd.h>
+
+QT_BEGIN_NAMESPACE
+
+// Both chips: register address bit 7 enables auto-increment for burst reads.
+static const int AUTO_INCREMENT = 0x80;
+static const int CTRL_REG1 = 0x20;
+static const int CTRL_REG2 = 0x21;
+static const int CTRL_REG2_ONE_SHOT = 0x01;
+static const int STATUS_REG = 0x27;
+static const int STATUS_DATA_AVAILABLE = 0x03;
+static const int ONE_SHOT_POLL_ATTEMPTS = 20;
+static const int ONE_SHOT_POLL_INTERVAL_US = 5000;
+
+static const int HTS221_AV_CONF = 0x10;
+static const int HTS221_CALIB_FIRST = 0x30;
+static const int HTS221_CALIB_COUNT = 16;
+
+static const int LPS25H_RES_CONF = 0x10;
+static const int LPS25H_FIFO_CTRL = 0x2E;
+
+static inline int toInt16(const uchar *p)
+{
+    return qint16(p[0] | (p[1] << 8));
+}
+
+// Starts a one-shot conversion when needed and fetches status and all output
+// registers with a single burst read.
+static bool readOutput(QSenseHatI2CBus *bus, int address, QSenseHatConversionMode mode, uchar *buf, int count)
+{
+    if (mode == QSenseHatOneShotConversion) {
+        if (!bus->write(address, CTRL_REG2, CTRL_REG2_ONE_SHOT))
+            return false;
+        // The conversion takes a few milliseconds.
+        for (int attempts = ONE_SHOT_POLL_ATTEMPTS; attempts; --attempts) {
+            if (!bus->read(address, STATUS_REG | AUTO_INCREMENT, buf, count))
+                return false;
+            if ((buf[0] & STATUS_DATA_AVAILABLE) == STATUS_DATA_AVAILABLE)
+                return true;
+            usleep(ONE_SHOT_POLL_INTERVAL_US);
+        }
+        return false;
+    }
+
+    return bus->read(address, STATUS_REG | AUTO_INCREMENT, buf, count);
+}
+
+bool QSenseHatHts221::init(QSenseHatConversionMode conversionMode)
+{
+    mode = conversionMode;
+    hasData = false;
+
+    uchar id = 0;
+    if (!bus->read(Address, WhoAmI, &id, 1) || id != WhoAmIValue) {
+        qWarning("HTS221 not found");
+        return false;
+    }
+
+    uchar c[HTS221_CALIB_COUNT];
+    if (!bus->read(Address, HTS221_CALIB_FIRST | AUTO_INCREMENT, c, HTS221_CALIB_COUNT))
+        return false;
+
+    h0 = c[0] / 2.0f;
+    h1 = c[1] / 2.0f;
+    t0 = (((c[5] & 0x03) << 8) | c[2]) / 8.0f;
+    t1 = (((c[5] & 0x0C) << 6) | c[3]) / 8.0f;
+    h0Out = toInt16(c + 6);
+    h1Out = toInt16(c + 10);
+    t0Out = toInt16(c + 12);
+    t1Out = toInt16(c + 14);
+    if (h0Out == h1Out || t0Out == t1Out) {
+        qWarning("Invalid HTS221 calibration data");
+        return false;
+    }
+
+    // 16 temperature and 32 humidity samples averaged internally. Powered up,
+    // block data update, 12.5 Hz or idle until a one-shot conversion is triggered.
+    return bus->write(Address, HTS221_AV_CONF, 0x1B)
+            && bus->write(Address, CTRL_REG1, mode == QSenseHatOneShotConversion ? 0x84 : 0x87);
+}
+
+bool QSenseHatHts221::read(float *humidity, float *temperature)
+{
+    uchar buf[5];
+    if (!readOutput(bus, Address, mode, buf, 5))
+        return false;
+
+    // With block data update the output registers always hold the last complete sample.
+    hasData |= (buf[0] & STATUS_DATA_AVAILABLE) == STATUS_DATA_AVAILABLE;
+    if (!hasData)
+        return true; // still converting after init(), e.g. 80 ms at 12.5 Hz
+
+    if (humidity) {
+        const float h = h0 + (h1 - h0) * (toInt16(buf + 1) - h0Out) / (h1Out - h0Out);
+        *humidity = qBound(0.0f, h, 100.0f);
+    }
+    if (temperature)
+        *temperature = t0 + (t1 - t0) * (toInt16(buf + 3) - t0Out) / (t1Out - t0Out);
+    return true;
+}
+
+bool QSenseHatHts221::powerDown()
+{
+    return bus->write(Address, CTRL_REG1, 0);
+}
+
+bool QSenseHatLps25h::init(QSenseHatConversionMode conversionMode)
+{
+    mode = conversionMode;
+    hasData = false;
+
+    uchar id = 0;
+    if (!bus->read(Address, WhoAmI, &id, 1) || id != WhoAmIValue) {
+        qWarning("LPS25H not found");
+        return false;
+    }
+
+    if (mode == QSenseHatOneShotConversion) {
+        // Powered up, block data update, idle until a conversion is triggered.
+        // Internal averaging of 32 pressure and 16 temperature samples.
+        return bus->write(Address, LPS25H_RES_CONF, 0x05)
+                && bus->write(Address, LPS25H_FIFO_CTRL, 0)
+                && bus->write(Address, CTRL_REG2, 0)
+                && bus->write(Address, CTRL_REG1, 0x84);
+    }
+
+    // Powered up, 25 Hz, block data update, with the FIFO in mean mode
+    // providing a moving average over 16 samples.
+    return bus->write(Address, LPS25H_RES_CONF, 0x05)
+            && bus->write(Address, LPS25H_FIFO_CTRL, 0xCF)
+            && bus->write(Address, CTRL_REG2, 0x40)
+            && bus->write(Address, CTRL_REG1, 0xC4);
+}
+
+bool QSenseHatLps25h::read(float *pressure, float *temperature)
+{
+    uchar buf[6];
+    if (!readOutput(bus, Address, mode, buf, 6))
+        return false;
+
+    hasData |= (buf[0] & STATUS_DATA_AVAILABLE) == STATUS_DATA_AVAILABLE;
+    if (!hasData)
+        return true; // the FIFO is still filling after init()
+
+    if (pressure) {
+        const qint32 raw = qint32((quint32(buf[3]) << 24) | (quint32(buf[2]) << 16) | (quint32(buf[1]) << 8)) >> 8;
+        *pressure = raw / 4096.0f;
+    }
+    if (temperature)
+        *temperature = 42.5f + toInt16(buf + 4) / 480.0f;
+    return true;
+}
+
+bool QSenseHatLps25h::powerDown()
+{
+    return bus->write(Address, CTRL_REG1, 0);
+}
+
+QT_END_NAMESPACE
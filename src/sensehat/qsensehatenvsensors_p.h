@@ -0,0 +1,119 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Sense HAT module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QSENSEHATENVSENSORS_P_H
+#define QSENSEHATENVSENSORS_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtSenseHat/qsenseglobal.h>
+
+QT_BEGIN_NAMESPACE
+
+class QSenseHatI2CBus;
+
+enum QSenseHatConversionMode {
+    QSenseHatOneShotConversion,
+    QSenseHatContinuousConversion
+};
+
+class QSENSEHAT_EXPORT QSenseHatHts221
+{
+public:
+    enum {
+        Address = 0x5F,
+        WhoAmI = 0x0F,
+        WhoAmIValue = 0xBC
+    };
+
+    explicit QSenseHatHts221(QSenseHatI2CBus *bus) : bus(bus) { }
+
+    bool init(QSenseHatConversionMode mode);
+    // Fails only on bus errors. Until the first conversion completes there is no
+    // sample yet, read() then leaves the values alone and hasSample() is false.
+    bool read(float *humidity, float *temperature);
+    bool hasSample() const { return hasData; }
+    bool powerDown();
+
+private:
+    QSenseHatI2CBus *bus;
+    QSenseHatConversionMode mode = QSenseHatContinuousConversion;
+    bool hasData = false;
+    // Calibration, read once in init().
+    float h0 = 0;
+    float h1 = 0;
+    int h0Out = 0;
+    int h1Out = 0;
+    float t0 = 0;
+    float t1 = 0;
+    int t0Out = 0;
+    int t1Out = 0;
+};
+
+class QSENSEHAT_EXPORT QSenseHatLps25h
+{
+public:
+    enum {
+        Address = 0x5C,
+        WhoAmI = 0x0F,
+        WhoAmIValue = 0xBD
+    };
+
+    explicit QSenseHatLps25h(QSenseHatI2CBus *bus) : bus(bus) { }
+
+    bool init(QSenseHatConversionMode mode);
+    bool read(float *pressure, float *temperature);
+    bool hasSample() const { return hasData; }
+    bool powerDown();
+
+private:
+    QSenseHatI2CBus *bus;
+    QSenseHatConversionMode mode = QSenseHatContinuousConversion;
+    bool hasData = false;
+};
+
+QT_END_NAMESPACE
+
+#endif
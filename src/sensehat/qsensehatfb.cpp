@@ -35,11 +35,24 @@
 ****************************************************************************/
 
 #include "qsensehatfb.h"
+#include "qsensehatfb_p.h"
 #include <private/qcore_unix_p.h>
+#include <QtCore/QAtomicInt>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
 #include <QtCore/QLoggingCategory>
+#include <QtCore/QMutex>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QThread>
+#include <QtCore/QVector>
+#include <QtCore/qendian.h>
 #include <QtGui/QImage>
 #include <linux/fb.h>
+#include <linux/memfd.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -47,6 +60,215 @@ Q_LOGGING_CATEGORY(qLcSH, "qt.sensehat")
 
 static const int RESET_GAMMA = 0xF102;
 
+// Default sub-frame period of the temporal dithering. rpi-sense-fb copies the
+// framebuffer to the matrix over I2C with deferred I/O, 10 ms after the first write,
+// and the transfer takes a few more. Sub-frames replaced before that are never shown,
+// which breaks the error feedback, so the period has to stay above the driver's.
+static const int DEFAULT_DITHER_INTERVAL_MS = 20;
+
+// Maps a source channel value to the RGB565 output level in 8.8 fixed point.
+struct QSenseHatDitherLut
+{
+    explicit QSenseHatDitherLut(int maxInput)
+    {
+        for (int v = 0; v <= maxInput; ++v) {
+            five[v] = quint16((v * 31 * 256 + maxInput / 2) / maxInput);
+            six[v] = quint16((v * 63 * 256 + maxInput / 2) / maxInput);
+        }
+    }
+
+    quint16 five[1024];
+    quint16 six[1024];
+};
+
+static const QSenseHatDitherLut &ditherLut(QSenseHatFb::DitherMode mode)
+{
+    static const QSenseHatDitherLut lut8(255);
+    static const QSenseHatDitherLut lut10(1023);
+    return mode == QSenseHatFb::TemporalDithering10 ? lut10 : lut8;
+}
+
+class QSenseHatDitherThread : public QThread
+{
+public:
+    QSenseHatDitherThread(uchar *data, int stride, const QSize &size);
+
+    void setFrame(const QImage &frame, QSenseHatFb::DitherMode mode);
+    void setInterval(int msecs) { interval.store(msecs); }
+
+protected:
+    void run() Q_DECL_OVERRIDE;
+
+private:
+    uchar *data;
+    int stride;
+    QSize size;
+    QMutex mutex;
+    QVector<quint16> pending;
+    bool hasPending = false;
+    QAtomicInt interval;
+};
+
+QSenseHatDitherThread::QSenseHatDitherThread(uchar *data, int stride, const QSize &size)
+    : data(data), stride(stride), size(size), interval(DEFAULT_DITHER_INTERVAL_MS)
+{
+    pending.resize(size.width() * size.height() * 3);
+}
+
+void QSenseHatDitherThread::setFrame(const QImage &frame, QSenseHatFb::DitherMode mode)
+{
+    const QSenseHatDitherLut &lut = ditherLut(mode);
+    QMutexLocker lock(&mutex);
+    quint16 *dst = pending.data();
+    for (int y = 0; y < size.height(); ++y) {
+        const quint32 *src = reinterpret_cast<const quint32 *>(frame.constScanLine(y));
+        for (int x = 0; x < size.width(); ++x) {
+            const quint32 p = src[x];
+            if (mode == QSenseHatFb::TemporalDithering10) {
+                *dst++ = lut.five[(p >> 20) & 0x3FF];
+                *dst++ = lut.six[(p >> 10) & 0x3FF];
+                *dst++ = lut.five[p & 0x3FF];
+            } else {
+                *dst++ = lut.five[qRed(p)];
+                *dst++ = lut.six[qGreen(p)];
+                *dst++ = lut.five[qBlue(p)];
+            }
+        }
+    }
+    hasPending = true;
+}
+
+void QSenseHatDitherThread::run()
+{
+    QVector<quint16> levels(pending.size());
+    // Per-channel accumulated quantization error, carried over to the next sub-frame.
+    QVector<quint8> error(pending.size(), 0x80);
+    QVector<quint16> subFrame(size.width() * size.height());
+    // Not a valid RGB565 frame of this size, so the first sub-frame is always stored.
+    QVector<quint16> shown;
+
+    while (!isInterruptionRequested()) {
+        mutex.lock();
+        if (hasPending) {
+            memcpy(levels.data(), pending.constData(), pending.size() * sizeof(quint16));
+            hasPending = false;
+        }
+        mutex.unlock();
+
+        const quint16 *lev = levels.constData();
+        quint8 *err = error.data();
+        quint16 *dst = subFrame.data();
+        for (int y = 0; y < size.height(); ++y, dst += size.width()) {
+            for (int x = 0; x < size.width(); ++x) {
+                const uint r = lev[0] + err[0];
+                const uint g = lev[1] + err[1];
+                const uint b = lev[2] + err[2];
+                err[0] = r & 0xFF;
+                err[1] = g & 0xFF;
+                err[2] = b & 0xFF;
+                dst[x] = ((r >> 8) << 11) | ((g >> 8) << 5) | (b >> 8);
+                lev += 3;
+                err += 3;
+            }
+        }
+
+        // Every store makes the driver schedule a transfer on the bus shared with
+        // the sensors, so only write when the sub-frame actually differs.
+        if (subFrame != shown) {
+            const quint16 *src = subFrame.constData();
+            for (int y = 0; y < size.height(); ++y, src += size.width())
+                memcpy(data + y * stride, src, size.width() * sizeof(quint16));
+            shown = subFrame;
+        }
+
+        msleep(interval.load());
+    }
+}
+
+// Box filter weights are the exact overlap of each source pixel with the output pixel,
+// in units of 1 / dst source pixels. Each output pixel's taps sum up to src, so nothing
+// is lost to rounding and the average is taken with a single division at the end.
+
+struct QSenseHatScaleWeights
+{
+    void compute(int src, int dst);
+
+    int srcSize = 0;
+    int dstSize = 0;
+    QVector<int> first; // first source pixel for each output pixel
+    QVector<int> offset; // index of the first tap in weights, dstSize + 1 entries
+    QVector<int> weights;
+};
+
+void QSenseHatScaleWeights::compute(int src, int dst)
+{
+    if (src == srcSize && dst == dstSize)
+        return;
+
+    srcSize = src;
+    dstSize = dst;
+    first.resize(dst);
+    offset.resize(dst + 1);
+    weights.clear();
+
+    // Positions are in units of 1 / dst source pixels, making the coverage exact.
+    for (int i = 0; i < dst; ++i) {
+        const qint64 start = qint64(i) * src;
+        const qint64 end = start + src;
+        const int j0 = int(start / dst);
+        const int j1 = int((end - 1) / dst);
+        first[i] = j0;
+        offset[i] = weights.size();
+        for (int j = j0; j <= j1; ++j)
+            weights.append(int(qMin(end, qint64(j + 1) * dst) - qMax(start, qint64(j) * dst)));
+    }
+    offset[dst] = weights.size();
+}
+
+void qt_sensehat_storePixels(QImage *dst, const QRgb *src)
+{
+    const int w = dst->width();
+    const int h = dst->height();
+    switch (dst->format()) {
+    case QImage::Format_RGB16:
+        for (int y = 0; y < h; ++y, src += w) {
+            quint16 *line = reinterpret_cast<quint16 *>(dst->scanLine(y));
+            for (int x = 0; x < w; ++x) {
+                const QRgb p = src[x];
+                line[x] = ((p >> 8) & 0xF800) | ((p >> 5) & 0x07E0) | ((p >> 3) & 0x001F);
+            }
+        }
+        break;
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+        for (int y = 0; y < h; ++y, src += w) {
+            QRgb *line = reinterpret_cast<QRgb *>(dst->scanLine(y));
+            for (int x = 0; x < w; ++x)
+                line[x] = 0xFF000000 | src[x];
+        }
+        break;
+    default:
+        for (int y = 0; y < h; ++y, src += w) {
+            for (int x = 0; x < w; ++x)
+                dst->setPixel(x, y, src[x]);
+        }
+        break;
+    }
+}
+
+struct QSenseHatFbLayer
+{
+    QImage image;
+    int opacity = 256;
+    bool visible = true;
+};
+
+static inline uint byteMul(uint x, uint a)
+{
+    const uint t = x * a + 0x80;
+    return (t + (t >> 8)) >> 8;
+}
+
 class QSenseHatFbPrivate
 {
 public:
@@ -54,6 +276,11 @@ public:
     ~QSenseHatFbPrivate();
 
     void open(const QString &framebufferDevice);
+    void stopDithering();
+    void downsample(const QImage &src, QImage *dst);
+    void composeLayers();
+
+    void capture();
 
     QSenseHatFb *q;
     int fd = -1;
@@ -63,13 +290,62 @@ public:
     int memSize = 0;
     int memOffset = 0;
     bool isBGR = false;
+    bool isVirtual = false;
     QImage image;
+    QSenseHatFb::DitherMode ditherMode = QSenseHatFb::NoDithering;
+    QImage ditherImage;
+    QSenseHatDitherThread *ditherThread = Q_NULLPTR;
+    int ditherInterval = DEFAULT_DITHER_INTERVAL_MS;
+    QSenseHatScaleWeights xWeights;
+    QSenseHatScaleWeights yWeights;
+    QVector<quint64> rowSum;
+    QVector<quint64> colSum;
+    QVector<QRgb> scaled;
+    QVector<QSenseHatFbLayer> layers;
+    bool layersDirty = false;
+    QVector<QRgb> composed;
+    QIODevice *captureDevice = Q_NULLPTR;
+    QScopedPointer<QFile> captureFile;
+    QImage::Format captureFormat = QImage::Format_Invalid;
+    QByteArray captureBuffer;
 };
 
+// What the rpi-sense-fb driver reports: 8x8 pixels, RGB565.
+static void virtualScreenInfo(fb_var_screeninfo *vinfo, fb_fix_screeninfo *finfo)
+{
+    vinfo->xres = vinfo->xres_virtual = 8;
+    vinfo->yres = vinfo->yres_virtual = 8;
+    vinfo->bits_per_pixel = 16;
+    vinfo->red.offset = 11;
+    vinfo->red.length = 5;
+    vinfo->green.offset = 5;
+    vinfo->green.length = 6;
+    vinfo->blue.offset = 0;
+    vinfo->blue.length = 5;
+    finfo->line_length = vinfo->xres * vinfo->bits_per_pixel / 8;
+    finfo->smem_len = finfo->line_length * vinfo->yres;
+}
+
+// Anonymous shared memory standing in for the device, for running without the HAT.
+static int openOffscreen()
+{
+    int fd = -1;
+#ifdef SYS_memfd_create
+    fd = syscall(SYS_memfd_create, "sensehat-fb", MFD_CLOEXEC);
+    if (fd != -1)
+        return fd;
+#endif
+    QByteArray fn = QFile::encodeName(QDir::tempPath() + QStringLiteral("/sensehat-fb-XXXXXX"));
+    fd = mkstemp(fn.data());
+    if (fd != -1)
+        unlink(fn.constData());
+    return fd;
+}
+
 void QSenseHatFbPrivate::open(const QString &framebufferDevice)
 {
-    QByteArray fn;
-    if (framebufferDevice.isEmpty()) {
+    QByteArray fn = framebufferDevice.isEmpty() ? qgetenv("QT_SENSEHAT_FRAMEBUFFER") : framebufferDevice.toUtf8();
+    if (fn.isEmpty()) {
         for (int i = 0; i < 4; ++i) {
             QByteArray candidate = QString(QStringLiteral("/sys/class/graphics/fb%1")).arg(i).toUtf8();
             QByteArray buf;
@@ -84,13 +360,14 @@ void QSenseHatFbPrivate::open(const QString &framebufferDevice)
                 break;
             }
         }
-    } else {
-        fn = framebufferDevice.toUtf8();
     }
 
     qCDebug(qLcSH, "Framebuffer device is %s", fn.constData());
 
-    fd = QT_OPEN(fn.constData(), O_RDWR);
+    if (fn == QByteArrayLiteral("offscreen"))
+        fd = openOffscreen();
+    else
+        fd = QT_OPEN(fn.constData(), O_RDWR);
     if (fd == -1) {
         qErrnoWarning(errno, "Failed to open %s", fn.constData());
         return;
@@ -100,13 +377,24 @@ void QSenseHatFbPrivate::open(const QString &framebufferDevice)
     fb_var_screeninfo vinfo;
     memset(&vinfo, 0, sizeof(vinfo));
     memset(&finfo, 0, sizeof(finfo));
-    if (ioctl(fd, FBIOGET_FSCREENINFO, &finfo)) {
-        qErrnoWarning(errno, "Error reading fixed fb information");
-        return;
-    }
-    if (ioctl(fd, FBIOGET_VSCREENINFO, &vinfo)) {
-        qErrnoWarning(errno, "Error reading variable fb information");
-        return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        // A plain file, e.g. for measurements without the HAT. Laid out like the real thing.
+        isVirtual = true;
+        virtualScreenInfo(&vinfo, &finfo);
+        if (st.st_size < off_t(finfo.smem_len) && ftruncate(fd, finfo.smem_len)) {
+            qErrnoWarning(errno, "Failed to resize %s", fn.constData());
+            return;
+        }
+    } else {
+        if (ioctl(fd, FBIOGET_FSCREENINFO, &finfo)) {
+            qErrnoWarning(errno, "Error reading fixed fb information");
+            return;
+        }
+        if (ioctl(fd, FBIOGET_VSCREENINFO, &vinfo)) {
+            qErrnoWarning(errno, "Error reading variable fb information");
+            return;
+        }
     }
 
     geometry = QRect(vinfo.xoffset, vinfo.yoffset, vinfo.xres, vinfo.yres);
@@ -179,8 +467,155 @@ void QSenseHatFbPrivate::open(const QString &framebufferDevice)
     image = QImage(data, geometry.width(), geometry.height(), stride, format);
 }
 
+void QSenseHatFbPrivate::stopDithering()
+{
+    if (!ditherThread)
+        return;
+
+    ditherThread->requestInterruption();
+    ditherThread->wait();
+    delete ditherThread;
+    ditherThread = Q_NULLPTR;
+
+    // Leave the last frame on the LEDs, quantized the plain way.
+    for (int y = 0; y < ditherImage.height(); ++y) {
+        for (int x = 0; x < ditherImage.width(); ++x)
+            image.setPixel(x, y, ditherImage.pixel(x, y));
+    }
+    ditherImage = QImage();
+    ditherMode = QSenseHatFb::NoDithering;
+}
+
+void QSenseHatFbPrivate::downsample(const QImage &src, QImage *dst)
+{
+    const int dw = dst->width();
+    const int dh = dst->height();
+    xWeights.compute(src.width(), dw);
+    yWeights.compute(src.height(), dh);
+    rowSum.resize(dw * 3);
+    colSum.resize(dw * 3);
+    scaled.resize(dw * dh);
+
+    const int *xw = xWeights.weights.constData();
+    const int *yw = yWeights.weights.constData();
+    // Every output pixel covers src.width() * src.height() weight units.
+    const quint64 area = quint64(src.width()) * src.height();
+    QRgb *out = scaled.data();
+    for (int i = 0; i < dh; ++i) {
+        colSum.fill(0);
+        for (int ty = yWeights.offset[i], sy = yWeights.first[i]; ty < yWeights.offset[i + 1]; ++ty, ++sy) {
+            const QRgb *line = reinterpret_cast<const QRgb *>(src.constScanLine(sy));
+            for (int j = 0; j < dw; ++j) {
+                quint64 r = 0, g = 0, b = 0;
+                for (int tx = xWeights.offset[j], sx = xWeights.first[j]; tx < xWeights.offset[j + 1]; ++tx, ++sx) {
+                    const QRgb p = line[sx];
+                    r += qRed(p) * xw[tx];
+                    g += qGreen(p) * xw[tx];
+                    b += qBlue(p) * xw[tx];
+                }
+                rowSum[j * 3] = r;
+                rowSum[j * 3 + 1] = g;
+                rowSum[j * 3 + 2] = b;
+            }
+            for (int k = 0; k < dw * 3; ++k)
+                colSum[k] += rowSum[k] * yw[ty];
+        }
+        for (int j = 0; j < dw; ++j) {
+            *out++ = qRgb(int((colSum[j * 3] + area / 2) / area),
+                          int((colSum[j * 3 + 1] + area / 2) / area),
+                          int((colSum[j * 3 + 2] + area / 2) / area));
+        }
+    }
+
+    qt_sensehat_storePixels(dst, scaled.constData());
+}
+
+void QSenseHatFbPrivate::composeLayers()
+{
+    QImage *dst = q->paintDevice();
+    composed.fill(0, dst->width() * dst->height());
+
+    // Source over, bottom to top, on premultiplied pixels.
+    for (int i = 0; i < layers.count(); ++i) {
+        const QSenseHatFbLayer &layer(layers.at(i));
+        if (!layer.visible || !layer.opacity)
+            continue;
+        QRgb *out = composed.data();
+        for (int y = 0; y < layer.image.height(); ++y) {
+            const QRgb *src = reinterpret_cast<const QRgb *>(layer.image.constScanLine(y));
+            for (int x = 0; x < layer.image.width(); ++x, ++out) {
+                const QRgb p = src[x];
+                const uint o = layer.opacity;
+                const uint a = (qAlpha(p) * o) >> 8;
+                if (!a)
+                    continue;
+                const uint ia = 255 - a;
+                const QRgb b = *out;
+                *out = qRgba(((qRed(p) * o) >> 8) + byteMul(qRed(b), ia),
+                             ((qGreen(p) * o) >> 8) + byteMul(qGreen(b), ia),
+                             ((qBlue(p) * o) >> 8) + byteMul(qBlue(b), ia),
+                             a + byteMul(qAlpha(b), ia));
+            }
+        }
+    }
+
+    qt_sensehat_storePixels(dst, composed.constData());
+    layersDirty = false;
+}
+
+// Capture stream, all values little endian:
+//   magic "QSHC", quint16 version
+//   followed by records, each starting with a quint8 type:
+//   'H': quint16 width, quint16 height, quint8 bytes per pixel, quint32 QImage::Format
+//   'F': quint64 timestamp in microseconds (CLOCK_MONOTONIC), then the pixels row by row
+// A header record precedes the first frame and every change of the pixel format.
+static const char CAPTURE_MAGIC[] = "QSHC";
+static const quint16 CAPTURE_VERSION = 1;
+
+// Held by the instance capturing to QT_SENSEHAT_CAPTURE, so that another one cannot truncate it.
+static QBasicAtomicInt captureClaimed = Q_BASIC_ATOMIC_INITIALIZER(0);
+
+template <typename T>
+static inline void appendLittleEndian(QByteArray *buf, T value)
+{
+    const int pos = buf->size();
+    buf->resize(pos + int(sizeof(T)));
+    qToLittleEndian(value, reinterpret_cast<uchar *>(buf->data() + pos));
+}
+
+void QSenseHatFbPrivate::capture()
+{
+    const QImage *frame = q->paintDevice();
+    if (frame->isNull())
+        return;
+
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    const int bpl = frame->width() * frame->depth() / 8;
+
+    captureBuffer.resize(0);
+    if (frame->format() != captureFormat) {
+        captureFormat = frame->format();
+        appendLittleEndian<quint8>(&captureBuffer, 'H');
+        appendLittleEndian<quint16>(&captureBuffer, frame->width());
+        appendLittleEndian<quint16>(&captureBuffer, frame->height());
+        appendLittleEndian<quint8>(&captureBuffer, frame->depth() / 8);
+        appendLittleEndian<quint32>(&captureBuffer, captureFormat);
+    }
+    appendLittleEndian<quint8>(&captureBuffer, 'F');
+    appendLittleEndian<quint64>(&captureBuffer, quint64(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000);
+    for (int y = 0; y < frame->height(); ++y)
+        captureBuffer.append(reinterpret_cast<const char *>(frame->constScanLine(y)), bpl);
+
+    if (captureDevice->write(captureBuffer) != captureBuffer.size()) {
+        qWarning("Failed to write captured frame, stopping capture");
+        captureDevice = Q_NULLPTR;
+    }
+}
+
 QSenseHatFbPrivate::~QSenseHatFbPrivate()
 {
+    stopDithering();
     if (fd != -1) {
         if (!image.isNull())
             munmap(image.bits() - memOffset, memSize);
@@ -194,11 +629,28 @@ QSenseHatFb::QSenseHatFb(const QString &framebufferDevice)
     d_ptr->open(framebufferDevice);
     if (isValid())
         setLowLight(false);
+
+    // Only one instance at a time captures, a second one (e.g. from QML) would truncate the
+    // stream. The claim is taken before opening, as opening truncates, and dropped on failure.
+    const QString captureFileName = QFile::decodeName(qgetenv("QT_SENSEHAT_CAPTURE"));
+    if (!captureFileName.isEmpty() && captureClaimed.testAndSetAcquire(0, 1)) {
+        QScopedPointer<QFile> file(new QFile(captureFileName));
+        if (file->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            d_ptr->captureFile.swap(file);
+            setCaptureDevice(d_ptr->captureFile.data());
+        } else {
+            qWarning("Failed to open %s for capturing", qPrintable(captureFileName));
+            captureClaimed.storeRelease(0);
+        }
+    }
 }
 
 QSenseHatFb::~QSenseHatFb()
 {
+    const bool capturing = !d_ptr->captureFile.isNull();
     delete d_ptr;
+    if (capturing)
+        captureClaimed.storeRelease(0);
 }
 
 bool QSenseHatFb::isValid() const
@@ -216,16 +668,181 @@ QSize QSenseHatFb::size() const
 void QSenseHatFb::setLowLight(bool enable)
 {
     Q_D(QSenseHatFb);
-    if (d->fd == -1)
+    if (d->fd == -1 || d->isVirtual)
         return;
 
     ioctl(d->fd, RESET_GAMMA, enable ? 1 : 0);
 }
 
+void QSenseHatFb::setDitherMode(DitherMode mode)
+{
+    Q_D(QSenseHatFb);
+    if (mode == d->ditherMode)
+        return;
+
+    if (mode != NoDithering && (d->image.isNull() || d->depth != 16)) {
+        qWarning("Temporal dithering is only supported with 16 bpp framebuffers");
+        return;
+    }
+
+    d->stopDithering();
+    if (mode == NoDithering)
+        return;
+
+    d->ditherMode = mode;
+    d->ditherImage = d->image.convertToFormat(mode == TemporalDithering10
+                                              ? QImage::Format_RGB30 : QImage::Format_RGB32);
+    d->ditherThread = new QSenseHatDitherThread(d->image.bits(), d->stride, d->geometry.size());
+    d->ditherThread->setFrame(d->ditherImage, mode);
+    d->ditherThread->setInterval(d->ditherInterval);
+    d->ditherThread->start();
+}
+
+void QSenseHatFb::setDitherInterval(int msecs)
+{
+    Q_D(QSenseHatFb);
+    d->ditherInterval = qMax(1, msecs);
+    if (d->ditherThread)
+        d->ditherThread->setInterval(d->ditherInterval);
+}
+
+int QSenseHatFb::ditherInterval() const
+{
+    Q_D(const QSenseHatFb);
+    return d->ditherInterval;
+}
+
+QSenseHatFb::DitherMode QSenseHatFb::ditherMode() const
+{
+    Q_D(const QSenseHatFb);
+    return d->ditherMode;
+}
+
 QImage *QSenseHatFb::paintDevice()
 {
     Q_D(QSenseHatFb);
-    return &d->image;
+    return d->ditherThread ? &d->ditherImage : &d->image;
+}
+
+void QSenseHatFb::drawImage(const QImage &image)
+{
+    Q_D(QSenseHatFb);
+    QImage *dst = paintDevice();
+    if (dst->isNull() || image.isNull())
+        return;
+
+    // Premultiplied, so that transparent areas average towards black.
+    if (image.format() == QImage::Format_RGB32 || image.format() == QImage::Format_ARGB32_Premultiplied)
+        d->downsample(image, dst);
+    else
+        d->downsample(image.convertToFormat(QImage::Format_ARGB32_Premultiplied), dst);
+}
+
+void QSenseHatFb::present()
+{
+    Q_D(QSenseHatFb);
+    if (d->layersDirty && !d->image.isNull())
+        d->composeLayers();
+    if (d->ditherThread)
+        d->ditherThread->setFrame(d->ditherImage, d->ditherMode);
+    if (d->captureDevice)
+        d->capture();
+}
+
+void QSenseHatFb::setCaptureDevice(QIODevice *device)
+{
+    Q_D(QSenseHatFb);
+    d->captureDevice = device;
+    d->captureFormat = QImage::Format_Invalid;
+    if (!device)
+        return;
+
+    QByteArray header(CAPTURE_MAGIC, 4);
+    appendLittleEndian<quint16>(&header, CAPTURE_VERSION);
+    if (device->write(header) != header.size()) {
+        qWarning("Failed to write capture header");
+        d->captureDevice = Q_NULLPTR;
+    }
+}
+
+QIODevice *QSenseHatFb::captureDevice() const
+{
+    Q_D(const QSenseHatFb);
+    return d->captureDevice;
+}
+
+void QSenseHatFb::setLayerCount(int count)
+{
+    Q_D(QSenseHatFb);
+    const int oldCount = d->layers.count();
+    d->layers.resize(qMax(0, count));
+    for (int i = oldCount; i < d->layers.count(); ++i) {
+        d->layers[i].image = QImage(d->geometry.size(), QImage::Format_ARGB32_Premultiplied);
+        d->layers[i].image.fill(Qt::transparent);
+    }
+    d->layersDirty = true;
+}
+
+int QSenseHatFb::layerCount() const
+{
+    Q_D(const QSenseHatFb);
+    return d->layers.count();
+}
+
+QImage *QSenseHatFb::layer(int index)
+{
+    Q_D(QSenseHatFb);
+    if (index < 0 || index >= d->layers.count())
+        return Q_NULLPTR;
+
+    return &d->layers[index].image;
+}
+
+void QSenseHatFb::setLayerOpacity(int index, qreal opacity)
+{
+    Q_D(QSenseHatFb);
+    if (index < 0 || index >= d->layers.count())
+        return;
+
+    d->layers[index].opacity = qRound(qBound<qreal>(0, opacity, 1) * 256);
+    d->layersDirty = true;
+}
+
+qreal QSenseHatFb::layerOpacity(int index) const
+{
+    Q_D(const QSenseHatFb);
+    if (index < 0 || index >= d->layers.count())
+        return 0;
+
+    return d->layers[index].opacity / qreal(256);
+}
+
+void QSenseHatFb::setLayerVisible(int index, bool visible)
+{
+    Q_D(QSenseHatFb);
+    if (index < 0 || index >= d->layers.count())
+        return;
+
+    d->layers[index].visible = visible;
+    d->layersDirty = true;
+}
+
+bool QSenseHatFb::isLayerVisible(int index) const
+{
+    Q_D(const QSenseHatFb);
+    if (index < 0 || index >= d->layers.count())
+        return false;
+
+    return d->layers[index].visible;
+}
+
+void QSenseHatFb::updateLayer(int index)
+{
+    Q_D(QSenseHatFb);
+    if (index < 0 || index >= d->layers.count())
+        return;
+
+    d->layersDirty = true;
 }
 
 QT_END_NAMESPACE
@@ -44,11 +44,18 @@
 QT_BEGIN_NAMESPACE
 
 class QImage;
+class QIODevice;
 class QSenseHatFbPrivate;
 
 class QSENSEHAT_EXPORT QSenseHatFb
 {
 public:
+    enum DitherMode {
+        NoDithering,
+        TemporalDithering8,
+        TemporalDithering10
+    };
+
     QSenseHatFb(const QString &framebufferDevice = QString());
     ~QSenseHatFb();
 
@@ -56,7 +63,26 @@ public:
     QSize size() const;
     void setLowLight(bool enable);
 
+    void setDitherMode(DitherMode mode);
+    DitherMode ditherMode() const;
+    void setDitherInterval(int msecs);
+    int ditherInterval() const;
+
     QImage *paintDevice();
+    void drawImage(const QImage &image);
+    void present();
+
+    void setLayerCount(int count);
+    int layerCount() const;
+    QImage *layer(int index);
+    void setLayerOpacity(int index, qreal opacity);
+    qreal layerOpacity(int index) const;
+    void setLayerVisible(int index, bool visible);
+    bool isLayerVisible(int index) const;
+    void updateLayer(int index);
+
+    void setCaptureDevice(QIODevice *device);
+    QIODevice *captureDevice() const;
 
 private:
     Q_DISABLE_COPY(QSenseHatFb)
@@ -0,0 +1,202 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Sense HAT module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qsensehati2c_p.h"
+#include "qsensehatenvsensors_p.h"
+#include <private/qcore_unix_p.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+QT_BEGIN_NAMESPACE
+
+static const int AUTO_INCREMENT = 0x80;
+static const int CTRL_REG1 = 0x20;
+static const int CTRL_REG1_POWER_ON = 0x80;
+static const int CTRL_REG1_ODR_MASK = 0x73; // bits 1:0 on the HTS221, 6:4 on the LPS25H
+static const int CTRL_REG2 = 0x21;
+static const int CTRL_REG2_ONE_SHOT = 0x01;
+static const int CTRL_REG2_BOOT = 0x80;
+static const int STATUS_REG = 0x27;
+static const int STATUS_DATA_AVAILABLE = 0x03;
+static const int OUTPUT_FIRST = 0x28;
+
+QSenseHatLinuxI2CBus::QSenseHatLinuxI2CBus(const QByteArray &device)
+{
+    fd = QT_OPEN(device.constData(), O_RDWR);
+    if (fd == -1)
+        qErrnoWarning(errno, "Failed to open %s", device.constData());
+}
+
+QSenseHatLinuxI2CBus::~QSenseHatLinuxI2CBus()
+{
+    if (fd != -1)
+        QT_CLOSE(fd);
+}
+
+bool QSenseHatLinuxI2CBus::read(int address, int reg, uchar *data, int count)
+{
+    if (fd == -1)
+        return false;
+
+    uchar r = reg;
+    i2c_msg msgs[2];
+    msgs[0].addr = address;
+    msgs[0].flags = 0;
+    msgs[0].len = 1;
+    msgs[0].buf = &r;
+    msgs[1].addr = address;
+    msgs[1].flags = I2C_M_RD;
+    msgs[1].len = count;
+    msgs[1].buf = data;
+    i2c_rdwr_ioctl_data rdwr;
+    rdwr.msgs = msgs;
+    rdwr.nmsgs = 2;
+    ++transactions;
+    return ioctl(fd, I2C_RDWR, &rdwr) == 2;
+}
+
+bool QSenseHatLinuxI2CBus::write(int address, int reg, uchar value)
+{
+    if (fd == -1)
+        return false;
+
+    uchar buf[2] = { uchar(reg), value };
+    i2c_msg msg;
+    msg.addr = address;
+    msg.flags = 0;
+    msg.len = 2;
+    msg.buf = buf;
+    i2c_rdwr_ioctl_data rdwr;
+    rdwr.msgs = &msg;
+    rdwr.nmsgs = 1;
+    ++transactions;
+    return ioctl(fd, I2C_RDWR, &rdwr) == 1;
+}
+
+QSenseHatSimulatedI2CBus::QSenseHatSimulatedI2CBus()
+{
+    setEnvironment(45, 1013.25f, 22);
+}
+
+uchar QSenseHatSimulatedI2CBus::registerValue(int address, int reg) const
+{
+    const QByteArray regs = registers.value(address);
+    return reg < regs.size() ? uchar(regs.at(reg)) : 0;
+}
+
+void QSenseHatSimulatedI2CBus::setRegisterValue(int address, int reg, uchar value)
+{
+    QByteArray &regs(registers[address]);
+    if (regs.isEmpty())
+        regs.fill(0, 128);
+    regs[reg & 0x7F] = char(value);
+}
+
+static inline void setRegister16(QSenseHatSimulatedI2CBus *bus, int address, int reg, int value)
+{
+    bus->setRegisterValue(address, reg, uchar(value));
+    bus->setRegisterValue(address, reg + 1, uchar(value >> 8));
+}
+
+void QSenseHatSimulatedI2CBus::setEnvironment(float humidity, float pressure, float temperature)
+{
+    // HTS221: 20..80 %rH maps to 0..12000, 10..40 C maps to 0..9000.
+    const int hts = QSenseHatHts221::Address;
+    setRegisterValue(hts, QSenseHatHts221::WhoAmI, QSenseHatHts221::WhoAmIValue);
+    const int t0x8 = 80;
+    const int t1x8 = 320;
+    setRegisterValue(hts, 0x30, 40);
+    setRegisterValue(hts, 0x31, 160);
+    setRegisterValue(hts, 0x32, uchar(t0x8));
+    setRegisterValue(hts, 0x33, uchar(t1x8));
+    setRegisterValue(hts, 0x35, ((t1x8 >> 8) << 2) | (t0x8 >> 8));
+    setRegister16(this, hts, 0x36, 0);
+    setRegister16(this, hts, 0x3A, 12000);
+    setRegister16(this, hts, 0x3C, 0);
+    setRegister16(this, hts, 0x3E, 9000);
+    setRegister16(this, hts, 0x28, qRound((humidity - 20) * 12000 / 60));
+    setRegister16(this, hts, 0x2A, qRound((temperature - 10) * 9000 / 30));
+    setRegisterValue(hts, STATUS_REG, STATUS_DATA_AVAILABLE);
+
+    const int lps = QSenseHatLps25h::Address;
+    setRegisterValue(lps, QSenseHatLps25h::WhoAmI, QSenseHatLps25h::WhoAmIValue);
+    const int p = qRound(pressure * 4096);
+    setRegisterValue(lps, 0x28, uchar(p));
+    setRegisterValue(lps, 0x29, uchar(p >> 8));
+    setRegisterValue(lps, 0x2A, uchar(p >> 16));
+    setRegister16(this, lps, 0x2B, qRound((temperature - 42.5f) * 480));
+    setRegisterValue(lps, STATUS_REG, STATUS_DATA_AVAILABLE);
+}
+
+bool QSenseHatSimulatedI2CBus::read(int address, int reg, uchar *data, int count)
+{
+    ++transactions;
+    if (!registers.contains(address))
+        return false;
+
+    const bool autoIncrement = reg & AUTO_INCREMENT;
+    reg &= ~AUTO_INCREMENT;
+    bool readOutput = false;
+    for (int i = 0; i < count; ++i) {
+        const int r = autoIncrement ? reg + i : reg;
+        data[i] = registerValue(address, r);
+        readOutput |= r >= OUTPUT_FIRST && r < OUTPUT_FIRST + 5;
+    }
+    // Reading the output registers consumes the sample, until the next one-shot conversion.
+    const int ctrl1 = registerValue(address, CTRL_REG1);
+    const bool continuous = (ctrl1 & CTRL_REG1_POWER_ON) && (ctrl1 & CTRL_REG1_ODR_MASK);
+    if (readOutput && !continuous)
+        setRegisterValue(address, STATUS_REG, 0);
+    return true;
+}
+
+bool QSenseHatSimulatedI2CBus::write(int address, int reg, uchar value)
+{
+    ++transactions;
+    if (!registers.contains(address))
+        return false;
+
+    reg &= ~AUTO_INCREMENT;
+    if (reg == CTRL_REG2) {
+        if (value & CTRL_REG2_ONE_SHOT)
+            setRegisterValue(address, STATUS_REG, STATUS_DATA_AVAILABLE);
+        value &= ~(CTRL_REG2_ONE_SHOT | CTRL_REG2_BOOT);
+    }
+    setRegisterValue(address, reg, value);
+    return true;
+}
+
+QT_END_NAMESPACE
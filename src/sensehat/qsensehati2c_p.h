@@ -0,0 +1,109 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Sense HAT module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QSENSEHATI2C_P_H
+#define QSENSEHATI2C_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtSenseHat/qsenseglobal.h>
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+
+QT_BEGIN_NAMESPACE
+
+class QSENSEHAT_EXPORT QSenseHatI2CBus
+{
+public:
+    virtual ~QSenseHatI2CBus() { }
+
+    // Reads count registers starting at reg in one combined transaction.
+    virtual bool read(int address, int reg, uchar *data, int count) = 0;
+    virtual bool write(int address, int reg, uchar value) = 0;
+
+    int transactionCount() const { return transactions; }
+    void resetTransactionCount() { transactions = 0; }
+
+protected:
+    int transactions = 0;
+};
+
+class QSENSEHAT_EXPORT QSenseHatLinuxI2CBus : public QSenseHatI2CBus
+{
+public:
+    QSenseHatLinuxI2CBus(const QByteArray &device = QByteArrayLiteral("/dev/i2c-1"));
+    ~QSenseHatLinuxI2CBus();
+
+    bool isValid() const { return fd != -1; }
+
+    bool read(int address, int reg, uchar *data, int count) Q_DECL_OVERRIDE;
+    bool write(int address, int reg, uchar value) Q_DECL_OVERRIDE;
+
+private:
+    int fd = -1;
+};
+
+// Register map of the HTS221 and LPS25H, without the hardware. Both chips use
+// the most significant bit of the register address for auto-increment, start
+// one-shot conversions via bit 0 of register 0x21 and flag new data in 0x27.
+class QSENSEHAT_EXPORT QSenseHatSimulatedI2CBus : public QSenseHatI2CBus
+{
+public:
+    QSenseHatSimulatedI2CBus();
+
+    uchar registerValue(int address, int reg) const;
+    void setRegisterValue(int address, int reg, uchar value);
+    void setEnvironment(float humidity, float pressure, float temperature);
+
+    bool read(int address, int reg, uchar *data, int count) Q_DECL_OVERRIDE;
+    bool write(int address, int reg, uchar value) Q_DECL_OVERRIDE;
+
+private:
+    QHash<int, QByteArray> registers;
+};
+
+QT_END_NAMESPACE
+
+#endif
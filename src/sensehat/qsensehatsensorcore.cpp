@@ -0,0 +1,688 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Sense HAT module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qsensehatsensorcore_p.h"
+#include "qsensehati2c_p.h"
+#include "qsensehatcompasscalibrator_p.h"
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QStandardPaths>
+#include <QtCore/qmath.h>
+#include <RTIMULib.h>
+#include <cmath>
+#include <time.h>
+#include <unistd.h>
+
+QT_BEGIN_NAMESPACE
+
+static const int MAX_READ_ATTEMPTS = 5;
+static const float RTIMULIB_COMPASS_ALPHA = 0.2f; // COMPASS_ALPHA in RTIMU.cpp
+
+// LSM9DS1 power-down, the magnetometer address is fixed on the Sense HAT.
+static const int LSM9DS1_MAG_ADDRESS = 0x1C;
+static const int LSM9DS1_CTRL_REG1_G = 0x10;
+static const int LSM9DS1_CTRL_REG6_XL = 0x20;
+static const int LSM9DS1_CTRL_REG3_M = 0x22;
+static const int LSM9DS1_CTRL_REG3_M_POWER_DOWN = 0x03;
+
+static const int SIMULATED_POLL_INTERVAL_MS = 5;
+static const float SIMULATED_YAW_RATE = 1.5f; // rad/s
+static const float SIMULATED_ROCK_AMPLITUDE = 0.3f; // rad
+static const float SIMULATED_ROCK_FREQUENCY = 0.5f; // Hz
+
+Q_DECLARE_LOGGING_CATEGORY(qLcSH)
+
+static inline quint64 monotonicUSecs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return quint64(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+class CLocale
+{
+public:
+    CLocale() {
+        oldLoc = QByteArray(setlocale(LC_ALL, 0));
+        setlocale(LC_ALL, "C");
+    }
+    ~CLocale() {
+        setlocale(LC_ALL, oldLoc.constData());
+    }
+private:
+    QByteArray oldLoc;
+};
+
+QSenseHatSensorCorePrivate::~QSenseHatSensorCorePrivate()
+{
+    delete compassCalibrator;
+    delete lps25h;
+    delete hts221;
+    if (ownsBus)
+        delete bus;
+    delete imuBus;
+    delete rtpressure;
+    delete rthumidity;
+    delete rtimu;
+    delete settings;
+}
+
+void QSenseHatSensorCorePrivate::open()
+{
+    if (flags.testFlag(QSenseHatSensorCore::OneShotConversions)) {
+        humidityMode = QSenseHatOneShotConversion;
+        pressureMode = QSenseHatOneShotConversion;
+    }
+
+    if (flags.testFlag(QSenseHatSensorCore::Simulated)) {
+        pollInterval = SIMULATED_POLL_INTERVAL_MS;
+        simulationStart = monotonicUSecs();
+        setI2CBus(new QSenseHatSimulatedI2CBus);
+        ownsBus = true;
+        qCDebug(qLcSH, "Using simulated sensors");
+        return;
+    }
+
+    CLocale c; // to avoid decimal separator trouble in the ini file
+    const QString configFileName = QStringLiteral("RTIMULib.ini");
+    const QString defaultConfig = QStringLiteral("/etc/") + configFileName;
+    const QString writableConfigDir = QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation) + QStringLiteral("/sense_hat");
+    const QString writableConfig = writableConfigDir + QStringLiteral("/") + configFileName;
+
+    if (!flags.testFlag(QSenseHatSensorCore::DontCopyIniFile)) {
+        if (!QFile::exists(writableConfig)) {
+            qCDebug(qLcSH) << "Copying" << defaultConfig << "to" << writableConfig;
+            if (QFile::exists(defaultConfig)) {
+                QDir(QStringLiteral("/")).mkpath(writableConfigDir);
+                QFile::copy(defaultConfig, writableConfig);
+            } else {
+                qWarning("/etc/RTIMULib.ini not found, sensors may not be functional");
+            }
+        }
+        QByteArray dirName = writableConfigDir.toUtf8();
+        settings = new RTIMUSettings(dirName.constData(), "RTIMULib");
+        settingsDir = writableConfigDir;
+    } else {
+        settings = new RTIMUSettings("/etc", "RTIMULib");
+    }
+
+    rtimu = RTIMU::createIMU(settings);
+    pollInterval = qMax(1, rtimu->IMUGetPollInterval());
+    qCDebug(qLcSH, "IMU name %s Recommended poll interval %d ms", rtimu->IMUName(), pollInterval);
+
+    // Only the native drivers can trigger one-shot conversions.
+    if (flags & (QSenseHatSensorCore::NativeEnvironmentalDrivers | QSenseHatSensorCore::OneShotConversions)) {
+        setI2CBus(new QSenseHatLinuxI2CBus);
+        ownsBus = true;
+        return;
+    }
+
+    rthumidity = RTHumidity::createHumidity(settings);
+    qCDebug(qLcSH, "Humidity sensor name %s", rthumidity->humidityName());
+
+    rtpressure = RTPressure::createPressure(settings);
+    qCDebug(qLcSH, "Pressure sensor name %s", rtpressure->pressureName());
+}
+
+void QSenseHatSensorCorePrivate::setI2CBus(QSenseHatI2CBus *i2cBus)
+{
+    delete lps25h;
+    delete hts221;
+    if (ownsBus)
+        delete bus;
+    ownsBus = false;
+
+    bus = i2cBus;
+    hts221 = new QSenseHatHts221(bus);
+    lps25h = new QSenseHatLps25h(bus);
+    humidityInited = false;
+    pressureInited = false;
+    qCDebug(qLcSH, "Using native HTS221 and LPS25H drivers");
+}
+
+void QSenseHatSensorCorePrivate::ensureNativeDrivers()
+{
+    if (hts221)
+        return;
+    setI2CBus(new QSenseHatLinuxI2CBus);
+    ownsBus = true;
+}
+
+bool QSenseHatSensorCorePrivate::powerDownImu()
+{
+    if (!rtimu)
+        return true;
+    if (rtimu->IMUType() != RTIMU_TYPE_LSM9DS1) {
+        qCDebug(qLcSH, "Cannot power down IMU type %d", rtimu->IMUType());
+        return false;
+    }
+
+    // Zero output data rates power down the gyro and then the accelerometer.
+    if (!imuBus)
+        imuBus = new QSenseHatLinuxI2CBus;
+    const int address = settings->m_I2CSlaveAddress;
+    return imuBus->write(address, LSM9DS1_CTRL_REG1_G, 0)
+            && imuBus->write(address, LSM9DS1_CTRL_REG6_XL, 0)
+            && imuBus->write(LSM9DS1_MAG_ADDRESS, LSM9DS1_CTRL_REG3_M, LSM9DS1_CTRL_REG3_M_POWER_DOWN);
+}
+
+static inline float toDeg360(float rad)
+{
+    const float deg = qRadiansToDegrees(rad);
+    return deg < 0 ? deg + 360 : deg;
+}
+
+static inline void copyVector(float *dst, const RTVector3 &v)
+{
+    dst[0] = v.x();
+    dst[1] = v.y();
+    dst[2] = v.z();
+}
+
+static inline QSenseHatSensorCore::Channels humidityChannels(bool temperatureFromHumidity)
+{
+    QSenseHatSensorCore::Channels c = QSenseHatSensorCore::Humidity;
+    if (temperatureFromHumidity)
+        c |= QSenseHatSensorCore::Temperature;
+    return c;
+}
+
+static inline QSenseHatSensorCore::Channels pressureChannels(bool temperatureFromHumidity)
+{
+    QSenseHatSensorCore::Channels c = QSenseHatSensorCore::Pressure;
+    if (!temperatureFromHumidity)
+        c |= QSenseHatSensorCore::Temperature;
+    return c;
+}
+
+static const QSenseHatSensorCore::Channels imuChannels = QSenseHatSensorCore::Gyro
+        | QSenseHatSensorCore::Acceleration | QSenseHatSensorCore::Compass
+        | QSenseHatSensorCore::Orientation;
+
+bool QSenseHatSensorCorePrivate::readHumidity(QSenseHatSensorSample &sample, QSenseHatSensorCore::Channels what)
+{
+    if (!what)
+        return true;
+
+    if (hts221) {
+        float h, t;
+        if (!hts221->read(&h, &t))
+            return false;
+        if (!hts221->hasSample())
+            return true; // like RTIMULib, valid stays unset until there is data
+        if (what & QSenseHatSensorCore::Humidity) {
+            sample.humidity = h;
+            sample.valid |= QSenseHatSensorCore::Humidity;
+        }
+        if (what & QSenseHatSensorCore::Temperature) {
+            sample.temperature = t;
+            sample.valid |= QSenseHatSensorCore::Temperature;
+        }
+        return true;
+    }
+
+    RTIMU_DATA data;
+    if (!rthumidity->humidityRead(data))
+        return false;
+    if ((what & QSenseHatSensorCore::Humidity) && data.humidityValid) {
+        sample.humidity = data.humidity;
+        sample.valid |= QSenseHatSensorCore::Humidity;
+    }
+    if ((what & QSenseHatSensorCore::Temperature) && data.temperatureValid) {
+        sample.temperature = data.temperature;
+        sample.valid |= QSenseHatSensorCore::Temperature;
+    }
+    return true;
+}
+
+bool QSenseHatSensorCorePrivate::readPressure(QSenseHatSensorSample &sample, QSenseHatSensorCore::Channels what)
+{
+    if (!what)
+        return true;
+
+    if (lps25h) {
+        float p, t;
+        if (!lps25h->read(&p, &t))
+            return false;
+        if (!lps25h->hasSample())
+            return true;
+        if (what & QSenseHatSensorCore::Pressure) {
+            sample.pressure = p;
+            sample.valid |= QSenseHatSensorCore::Pressure;
+        }
+        if (what & QSenseHatSensorCore::Temperature) {
+            sample.temperature = t;
+            sample.valid |= QSenseHatSensorCore::Temperature;
+        }
+        return true;
+    }
+
+    RTIMU_DATA data;
+    if (!rtpressure->pressureRead(data))
+        return false;
+    if ((what & QSenseHatSensorCore::Pressure) && data.pressureValid) {
+        sample.pressure = data.pressure;
+        sample.valid |= QSenseHatSensorCore::Pressure;
+    }
+    if ((what & QSenseHatSensorCore::Temperature) && data.temperatureValid) {
+        sample.temperature = data.temperature;
+        sample.valid |= QSenseHatSensorCore::Temperature;
+    }
+    return true;
+}
+
+bool QSenseHatSensorCorePrivate::readImu(QSenseHatSensorSample &sample, QSenseHatSensorCore::Channels what)
+{
+    if (!what)
+        return true;
+
+    if (!rtimu) {
+        simulateImu(sample, what);
+        return true;
+    }
+
+    int attempts = MAX_READ_ATTEMPTS;
+    while (attempts--) {
+        if (rtimu->IMURead())
+            break;
+        usleep(pollInterval * 1000);
+    }
+    if (attempts < 0)
+        return false;
+
+    const RTIMU_DATA &data(rtimu->getIMUData());
+    if (data.compassValid) {
+        float average[3];
+        copyVector(average, data.compass);
+        float raw[3];
+        if (uncalibratedCompass(average, raw) && compassCalibrator)
+            compassCalibrator->addSample(raw);
+    }
+
+    if ((what & QSenseHatSensorCore::Gyro) && data.gyroValid) {
+        copyVector(sample.gyro, data.gyro);
+        sample.valid |= QSenseHatSensorCore::Gyro;
+    }
+    if ((what & QSenseHatSensorCore::Acceleration) && data.accelValid) {
+        copyVector(sample.acceleration, data.accel);
+        sample.valid |= QSenseHatSensorCore::Acceleration;
+    }
+    if ((what & QSenseHatSensorCore::Compass) && data.compassValid) {
+        copyVector(sample.compass, data.compass);
+        sample.valid |= QSenseHatSensorCore::Compass;
+    }
+    if ((what & QSenseHatSensorCore::Orientation) && data.fusionPoseValid) {
+        sample.orientation[0] = toDeg360(data.fusionPose.x()); // roll
+        sample.orientation[1] = toDeg360(data.fusionPose.y()); // pitch
+        sample.orientation[2] = toDeg360(data.fusionPose.z()); // yaw
+        sample.valid |= QSenseHatSensorCore::Orientation;
+    }
+    return true;
+}
+
+void QSenseHatSensorCorePrivate::simulateImu(QSenseHatSensorSample &sample, QSenseHatSensorCore::Channels what)
+{
+    // Turning around the z axis while rocking around x, in RTIMULib units.
+    const float t = (monotonicUSecs() - simulationStart) / 1000000.0f;
+    const float w = 2 * float(M_PI) * SIMULATED_ROCK_FREQUENCY;
+    const float roll = SIMULATED_ROCK_AMPLITUDE * qSin(w * t);
+    const float yaw = std::fmod(SIMULATED_YAW_RATE * t, 2 * float(M_PI));
+
+    if (what & QSenseHatSensorCore::Gyro) {
+        sample.gyro[0] = SIMULATED_ROCK_AMPLITUDE * w * qCos(w * t);
+        sample.gyro[1] = 0;
+        sample.gyro[2] = SIMULATED_YAW_RATE;
+        sample.valid |= QSenseHatSensorCore::Gyro;
+    }
+    if (what & QSenseHatSensorCore::Acceleration) {
+        sample.acceleration[0] = 0;
+        sample.acceleration[1] = qSin(roll);
+        sample.acceleration[2] = qCos(roll);
+        sample.valid |= QSenseHatSensorCore::Acceleration;
+    }
+    if (what & QSenseHatSensorCore::Compass) {
+        sample.compass[0] = 20 * qCos(yaw);
+        sample.compass[1] = -20 * qSin(yaw);
+        sample.compass[2] = -40;
+        sample.valid |= QSenseHatSensorCore::Compass;
+    }
+    if (what & QSenseHatSensorCore::Orientation) {
+        sample.orientation[0] = toDeg360(roll);
+        sample.orientation[1] = 0;
+        sample.orientation[2] = toDeg360(yaw);
+        sample.valid |= QSenseHatSensorCore::Orientation;
+    }
+}
+
+void QSenseHatSensorCorePrivate::setCompassCalibration(const QSenseHatCompassCalibration &calibration)
+{
+    settings->m_compassCalValid = true;
+    settings->m_compassCalMin = RTVector3(calibration.min[0], calibration.min[1], calibration.min[2]);
+    settings->m_compassCalMax = RTVector3(calibration.max[0], calibration.max[1], calibration.max[2]);
+    settings->m_compassCalEllipsoidValid = true;
+    settings->m_compassCalEllipsoidOffset = RTVector3(calibration.ellipsoidOffset[0],
+                                                      calibration.ellipsoidOffset[1],
+                                                      calibration.ellipsoidOffset[2]);
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j)
+            settings->m_compassCalEllipsoidCorr[i][j] = calibration.ellipsoidCorr[i][j];
+    }
+    rtimu->setCalibrationData();
+    updateCompassCorrection();
+}
+
+// Mirrors RTIMU::setCalibrationData().
+void QSenseHatSensorCorePrivate::updateCompassCorrection()
+{
+    compassCorrected = false;
+    if (!settings->m_compassCalValid)
+        return;
+
+    float maxDelta = -1;
+    for (int i = 0; i < 3; ++i)
+        maxDelta = qMax(maxDelta, settings->m_compassCalMax.data(i) - settings->m_compassCalMin.data(i));
+    if (maxDelta <= 0)
+        return;
+
+    for (int i = 0; i < 3; ++i) {
+        const float delta = settings->m_compassCalMax.data(i) - settings->m_compassCalMin.data(i);
+        if (delta <= 0)
+            return;
+        compassScale[i] = maxDelta / delta;
+        compassOffset[i] = (settings->m_compassCalMax.data(i) + settings->m_compassCalMin.data(i)) / 2;
+    }
+
+    compassEllipsoid = settings->m_compassCalEllipsoidValid;
+    if (compassEllipsoid) {
+        const float (*c)[3] = settings->m_compassCalEllipsoidCorr;
+        float (*inv)[3] = compassEllipsoidInverse;
+        for (int i = 0; i < 3; ++i) {
+            compassEllipsoidOffset[i] = settings->m_compassCalEllipsoidOffset.data(i);
+            // Adjugate, transposed: the cofactors of row i go into column i.
+            const int i1 = (i + 1) % 3;
+            const int i2 = (i + 2) % 3;
+            for (int j = 0; j < 3; ++j) {
+                const int j1 = (j + 1) % 3;
+                const int j2 = (j + 2) % 3;
+                inv[j][i] = c[i1][j1] * c[i2][j2] - c[i1][j2] * c[i2][j1];
+            }
+        }
+        const float det = c[0][0] * inv[0][0] + c[0][1] * inv[1][0] + c[0][2] * inv[2][0];
+        if (qFuzzyIsNull(det))
+            return;
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j)
+                inv[i][j] /= det;
+        }
+    }
+    compassCorrected = true;
+}
+
+// RTIMULib reports a running average of the calibrated compass readings. Undoing the average
+// recovers the current reading exactly, so the calibrator sees every reading once and without
+// the lag of the average. Undoing the calibration then gives the raw reading.
+bool QSenseHatSensorCorePrivate::uncalibratedCompass(const float *average, float *raw)
+{
+    const bool hadAverage = hasCompassAverage;
+    float reading[3];
+    for (int i = 0; i < 3; ++i) {
+        reading[i] = (average[i] - (1 - RTIMULIB_COMPASS_ALPHA) * compassAverage[i]) / RTIMULIB_COMPASS_ALPHA;
+        compassAverage[i] = average[i];
+    }
+    hasCompassAverage = true;
+    if (!hadAverage)
+        return false;
+
+    if (!compassCorrected) {
+        for (int i = 0; i < 3; ++i)
+            raw[i] = reading[i];
+        return true;
+    }
+
+    if (compassEllipsoid) {
+        float v[3];
+        for (int i = 0; i < 3; ++i) {
+            v[i] = compassEllipsoidOffset[i];
+            for (int j = 0; j < 3; ++j)
+                v[i] += compassEllipsoidInverse[i][j] * reading[j];
+        }
+        for (int i = 0; i < 3; ++i)
+            reading[i] = v[i];
+    }
+    for (int i = 0; i < 3; ++i)
+        raw[i] = reading[i] / compassScale[i] + compassOffset[i];
+    return true;
+}
+
+QSenseHatSensorCore::QSenseHatSensorCore(InitFlags flags)
+    : d_ptr(new QSenseHatSensorCorePrivate(flags))
+{
+    d_ptr->open();
+}
+
+QSenseHatSensorCore::~QSenseHatSensorCore()
+{
+    delete d_ptr;
+}
+
+int QSenseHatSensorCore::pollInterval() const
+{
+    Q_D(const QSenseHatSensorCore);
+    return d->pollInterval;
+}
+
+void QSenseHatSensorCore::setOnlineCompassCalibration(bool enable)
+{
+    Q_D(QSenseHatSensorCore);
+    if (enable == (d->compassCalibrator != Q_NULLPTR))
+        return;
+
+    if (!enable) {
+        delete d->compassCalibrator; // saves the latest fit
+        d->compassCalibrator = Q_NULLPTR;
+        return;
+    }
+
+    if (!d->rtimu) {
+        qWarning("Online compass calibration is not available with simulated sensors");
+        return;
+    }
+
+    // The existing calibration, including an ellipsoid fit, stays in use until the first fit
+    // replaces all of it.
+    d->updateCompassCorrection();
+
+    d->compassCalibrator = new QSenseHatCompassCalibrator(d->settingsDir);
+    d->compassCalibrator->start(QThread::LowPriority);
+}
+
+// RTIMULib logs every calibration change, so this is kept out of read().
+bool QSenseHatSensorCore::updateCompassCalibration()
+{
+    Q_D(QSenseHatSensorCore);
+    QSenseHatCompassCalibration calibration;
+    if (!d->compassCalibrator || !d->compassCalibrator->takeCalibration(&calibration))
+        return false;
+    d->setCompassCalibration(calibration);
+    return true;
+}
+
+bool QSenseHatSensorCore::onlineCompassCalibration() const
+{
+    Q_D(const QSenseHatSensorCore);
+    return d->compassCalibrator != Q_NULLPTR;
+}
+
+bool QSenseHatSensorCore::init(Channels what)
+{
+    Q_D(QSenseHatSensorCore);
+    bool ok = true;
+
+    if ((what & humidityChannels(d->temperatureFromHumidity)) && !d->humidityInited) {
+        d->humidityInited = true;
+        if (d->hts221 ? !d->hts221->init(d->humidityMode) : !d->rthumidity->humidityInit()) {
+            qWarning("Failed to initialize humidity sensor");
+            ok = false;
+        }
+    }
+
+    if ((what & pressureChannels(d->temperatureFromHumidity)) && !d->pressureInited) {
+        d->pressureInited = true;
+        if (d->lps25h ? !d->lps25h->init(d->pressureMode) : !d->rtpressure->pressureInit()) {
+            qWarning("Failed to initialize pressure sensor");
+            ok = false;
+        }
+    }
+
+    if ((what & imuChannels) && !d->imuInited) {
+        d->imuInited = true;
+        d->hasCompassAverage = false;
+        if (d->rtimu && !d->rtimu->IMUInit()) {
+            qWarning("Failed to initialize IMU");
+            ok = false;
+        }
+    }
+
+    return ok;
+}
+
+// Powers down the sensors providing what. The next read() or init() brings them back.
+// A sensor goes down with all its channels, see sensorChannels().
+bool QSenseHatSensorCore::suspend(Channels what)
+{
+    Q_D(QSenseHatSensorCore);
+    bool ok = true;
+
+    // Powered down even when not initialized yet, they may still be running from an earlier process.
+    if (what & humidityChannels(d->temperatureFromHumidity)) {
+        d->ensureNativeDrivers();
+        d->humidityInited = false;
+        if (!d->hts221->powerDown())
+            ok = false;
+    }
+
+    if (what & pressureChannels(d->temperatureFromHumidity)) {
+        d->ensureNativeDrivers();
+        d->pressureInited = false;
+        if (!d->lps25h->powerDown())
+            ok = false;
+    }
+
+    if (what & imuChannels) {
+        d->imuInited = false;
+        if (!d->powerDownImu())
+            ok = false;
+    }
+
+    if (!ok)
+        qWarning("Failed to power down sensors");
+    return ok;
+}
+
+// All channels provided by the sensors providing what.
+QSenseHatSensorCore::Channels QSenseHatSensorCore::sensorChannels(Channels what) const
+{
+    Q_D(const QSenseHatSensorCore);
+    Channels result;
+    const Channels groups[] = {
+        humidityChannels(d->temperatureFromHumidity),
+        pressureChannels(d->temperatureFromHumidity),
+        imuChannels
+    };
+    for (const Channels &group : groups) {
+        if (what & group)
+            result |= group;
+    }
+    return result;
+}
+
+// The sensors providing what convert on demand in read(), the others continuously.
+// Only affects humidity and pressure, and is always on with the OneShotConversions flag.
+void QSenseHatSensorCore::setOneShotConversions(Channels what)
+{
+    Q_D(QSenseHatSensorCore);
+    const bool all = d->flags.testFlag(OneShotConversions);
+    const QSenseHatConversionMode humidityMode = all || (what & humidityChannels(d->temperatureFromHumidity))
+            ? QSenseHatOneShotConversion : QSenseHatContinuousConversion;
+    const QSenseHatConversionMode pressureMode = all || (what & pressureChannels(d->temperatureFromHumidity))
+            ? QSenseHatOneShotConversion : QSenseHatContinuousConversion;
+
+    if (humidityMode == QSenseHatOneShotConversion || pressureMode == QSenseHatOneShotConversion)
+        d->ensureNativeDrivers();
+    if (humidityMode != d->humidityMode) {
+        d->humidityMode = humidityMode;
+        d->humidityInited = false;
+    }
+    if (pressureMode != d->pressureMode) {
+        d->pressureMode = pressureMode;
+        d->pressureInited = false;
+    }
+}
+
+QSenseHatSensorCore::Channels QSenseHatSensorCore::oneShotConversions() const
+{
+    Q_D(const QSenseHatSensorCore);
+    Channels result;
+    if (d->humidityMode == QSenseHatOneShotConversion)
+        result |= humidityChannels(d->temperatureFromHumidity);
+    if (d->pressureMode == QSenseHatOneShotConversion)
+        result |= pressureChannels(d->temperatureFromHumidity);
+    return result;
+}
+
+bool QSenseHatSensorCore::read(QSenseHatSensorSample &sample, Channels what)
+{
+    Q_D(QSenseHatSensorCore);
+    init(what);
+
+    bool ok = true;
+    sample.valid = 0;
+
+    if (!d->readHumidity(sample, what & humidityChannels(d->temperatureFromHumidity)))
+        ok = false;
+
+    if (!d->readPressure(sample, what & pressureChannels(d->temperatureFromHumidity)))
+        ok = false;
+
+    if (!d->readImu(sample, what & imuChannels))
+        ok = false;
+
+    sample.timestamp = monotonicUSecs();
+    return ok;
+}
+
+QT_END_NAMESPACE
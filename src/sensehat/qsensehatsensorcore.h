@@ -0,0 +1,113 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Sense HAT module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QSENSEHATSENSORCORE_H
+#define QSENSEHATSENSORCORE_H
+
+#include <QtSenseHat/qsenseglobal.h>
+#include <QtCore/qflags.h>
+
+QT_BEGIN_NAMESPACE
+
+struct QSenseHatSensorSample
+{
+    quint64 timestamp; // microseconds, CLOCK_MONOTONIC
+    uint valid; // QSenseHatSensorCore::Channels updated by the last read()
+    float humidity;
+    float pressure;
+    float temperature;
+    float gyro[3];
+    float acceleration[3];
+    float compass[3];
+    float orientation[3];
+};
+
+Q_DECLARE_TYPEINFO(QSenseHatSensorSample, Q_PRIMITIVE_TYPE);
+
+class QSenseHatSensorCorePrivate;
+
+class QSENSEHAT_EXPORT QSenseHatSensorCore
+{
+public:
+    enum InitFlag {
+        DontCopyIniFile = 0x01,
+        NativeEnvironmentalDrivers = 0x02,
+        Simulated = 0x04,
+        OneShotConversions = 0x08
+    };
+    Q_DECLARE_FLAGS(InitFlags, InitFlag)
+
+    enum Channel {
+        Humidity = 0x01,
+        Pressure = 0x02,
+        Temperature = 0x04,
+        Gyro = 0x08,
+        Acceleration = 0x10,
+        Compass = 0x20,
+        Orientation = 0x40,
+        AllChannels = 0xFF
+    };
+    Q_DECLARE_FLAGS(Channels, Channel)
+
+    QSenseHatSensorCore(InitFlags flags = 0);
+    ~QSenseHatSensorCore();
+
+    int pollInterval() const;
+
+    void setOnlineCompassCalibration(bool enable);
+    bool onlineCompassCalibration() const;
+    bool updateCompassCalibration();
+
+    bool init(Channels what = AllChannels);
+    bool read(QSenseHatSensorSample &sample, Channels what = AllChannels);
+    bool suspend(Channels what = AllChannels);
+    Channels sensorChannels(Channels what) const;
+
+    void setOneShotConversions(Channels what);
+    Channels oneShotConversions() const;
+
+private:
+    Q_DISABLE_COPY(QSenseHatSensorCore)
+    Q_DECLARE_PRIVATE(QSenseHatSensorCore)
+    QSenseHatSensorCorePrivate *d_ptr;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(QSenseHatSensorCore::InitFlags)
+Q_DECLARE_OPERATORS_FOR_FLAGS(QSenseHatSensorCore::Channels)
+
+QT_END_NAMESPACE
+
+#endif
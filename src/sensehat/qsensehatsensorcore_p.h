@@ -0,0 +1,127 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Sense HAT module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QSENSEHATSENSORCORE_P_H
+#define QSENSEHATSENSORCORE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qsensehatsensorcore.h"
+#include "qsensehatenvsensors_p.h"
+#include <QtCore/QString>
+
+class RTIMUSettings;
+class RTIMU;
+class RTHumidity;
+class RTPressure;
+
+QT_BEGIN_NAMESPACE
+
+class QSenseHatI2CBus;
+class QSenseHatCompassCalibrator;
+struct QSenseHatCompassCalibration;
+
+class QSENSEHAT_EXPORT QSenseHatSensorCorePrivate
+{
+public:
+    QSenseHatSensorCorePrivate(QSenseHatSensorCore::InitFlags flags) : flags(flags) { }
+    ~QSenseHatSensorCorePrivate();
+
+    static QSenseHatSensorCorePrivate *get(QSenseHatSensorCore *core) { return core->d_func(); }
+
+    void open();
+    // Switches humidity and pressure to the native drivers on the given bus, which is not owned.
+    void setI2CBus(QSenseHatI2CBus *i2cBus);
+    // RTIMULib can neither power down the HTS221 and LPS25H nor trigger one-shot conversions.
+    void ensureNativeDrivers();
+    bool powerDownImu();
+
+    bool readHumidity(QSenseHatSensorSample &sample, QSenseHatSensorCore::Channels what);
+    bool readPressure(QSenseHatSensorSample &sample, QSenseHatSensorCore::Channels what);
+    bool readImu(QSenseHatSensorSample &sample, QSenseHatSensorCore::Channels what);
+    void simulateImu(QSenseHatSensorSample &sample, QSenseHatSensorCore::Channels what);
+    // Applies a fitted compass calibration, between two IMU reads.
+    void setCompassCalibration(const QSenseHatCompassCalibration &calibration);
+    void updateCompassCorrection();
+    bool uncalibratedCompass(const float *average, float *raw);
+
+    QSenseHatSensorCore::InitFlags flags;
+    RTIMUSettings *settings = Q_NULLPTR;
+    QString settingsDir; // writable copy of RTIMULib.ini, if any
+    RTIMU *rtimu = Q_NULLPTR;
+    bool imuInited = false;
+    int pollInterval;
+    RTHumidity *rthumidity = Q_NULLPTR;
+    bool humidityInited = false;
+    RTPressure *rtpressure = Q_NULLPTR;
+    bool pressureInited = false;
+    bool temperatureFromHumidity = true;
+
+    QSenseHatI2CBus *bus = Q_NULLPTR;
+    bool ownsBus = false;
+    // Only for powering down the LSM9DS1, so that the environmental sensors keep their drivers.
+    QSenseHatI2CBus *imuBus = Q_NULLPTR;
+    QSenseHatHts221 *hts221 = Q_NULLPTR;
+    QSenseHatLps25h *lps25h = Q_NULLPTR;
+    QSenseHatConversionMode humidityMode = QSenseHatContinuousConversion;
+    QSenseHatConversionMode pressureMode = QSenseHatContinuousConversion;
+    quint64 simulationStart = 0;
+
+    QSenseHatCompassCalibrator *compassCalibrator = Q_NULLPTR;
+    // What RTIMULib currently does to the raw compass values, to undo it for the calibrator.
+    bool compassCorrected = false;
+    float compassOffset[3];
+    float compassScale[3];
+    bool compassEllipsoid = false;
+    float compassEllipsoidOffset[3];
+    float compassEllipsoidInverse[3][3];
+    // The previous running average RTIMULib reported, see uncalibratedCompass().
+    bool hasCompassAverage = false;
+    float compassAverage[3];
+};
+
+QT_END_NAMESPACE
+
+#endif
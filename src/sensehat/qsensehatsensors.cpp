@@ -35,42 +35,73 @@
 ****************************************************************************/
 
 #include "qsensehatsensors.h"
-#include <QStandardPaths>
-#include <QFile>
+#include "qsensehatsensorcore.h"
 #include <QTimer>
-#include <RTIMULib.h>
-#include <unistd.h>
 
 QT_BEGIN_NAMESPACE
 
-static const int MAX_READ_ATTEMPTS = 5;
+// Adaptive polling: below these thresholds the device is considered to be at rest.
+static const float ACCEL_VARIANCE_THRESHOLD = 0.0004f; // g^2
+static const float GYRO_THRESHOLD = 0.05f; // rad/s
+static const float VARIANCE_SMOOTHING = 0.2f;
+static const int STATIONARY_TIMEOUT_MS = 2000;
+static const int STATIONARY_POLL_INTERVAL_MS = 250;
+static const int PRETRIGGER_SAMPLES = 32;
 
-Q_DECLARE_LOGGING_CATEGORY(qLcSH)
+static const int COMPASS_CALIBRATION_INTERVAL_MS = 1000;
+
+// The LPS25H outputs at 25 Hz, the HTS221 at 12.5 Hz. Reading faster only returns the same values.
+static const int ENV_POLL_INTERVAL_MS = 40;
+
+static const QSenseHatSensors::UpdateFlags imuUpdateFlags = QSenseHatSensors::UpdateGyro
+        | QSenseHatSensors::UpdateAcceleration | QSenseHatSensors::UpdateCompass
+        | QSenseHatSensors::UpdateOrientation;
+
+static const QSenseHatSensors::UpdateFlags envUpdateFlags = QSenseHatSensors::UpdateHumidity
+        | QSenseHatSensors::UpdatePressure | QSenseHatSensors::UpdateTemperature;
 
 class QSenseHatSensorsPrivate
 {
 public:
     QSenseHatSensorsPrivate(QSenseHatSensors *q_ptr, QSenseHatSensors::InitFlags flags)
-        : q(q_ptr), flags(flags) { }
+        : q(q_ptr), core(QSenseHatSensorCore::InitFlags(QFlag(int(flags)))) { }
     ~QSenseHatSensorsPrivate();
 
-    void open();
+    QSenseHatSensorSubscription *subscribe(QSenseHatSensors::UpdateFlags what, qreal maxRate);
+    void unsubscribe(QSenseHatSensorSubscription *subscription);
+    void reschedule();
+
     void update(QSenseHatSensors::UpdateFlags what);
-    void report(const RTIMU_DATA &data, QSenseHatSensors::UpdateFlags what);
+    void pollImu();
+    void dutyCycle();
+    QSenseHatSensorCore::Channels dutyIdle() const;
+    void adapt(const QSenseHatSensorSample &sample);
+    void setStationary(bool enable);
+    void report(const QSenseHatSensorSample &sample, QSenseHatSensors::UpdateFlags what);
 
     QSenseHatSensors *q;
-    QSenseHatSensors::InitFlags flags;
-    RTIMUSettings *settings = Q_NULLPTR;
-    RTIMU *rtimu = Q_NULLPTR;
-    bool imuInited = false;
-    int pollInterval;
-    RTHumidity *rthumidity = Q_NULLPTR;
-    bool humidityInited = false;
-    RTPressure *rtpressure = Q_NULLPTR;
-    bool pressureInited = false;
+    QSenseHatSensorCore core;
+    QSenseHatSensorSample sample = QSenseHatSensorSample();
+    QVector<QSenseHatSensorSubscription *> subscriptions;
+    QSenseHatSensorSubscription *autoPollSubscription = Q_NULLPTR;
+    // One timer per group of sensors read together, each running only while subscribed to.
     QTimer pollTimer;
-    QSenseHatSensors::UpdateFlags autoPollWhat;
-    bool temperatureFromHumidity = true;
+    QSenseHatSensors::UpdateFlags imuWhat;
+    int imuInterval = 0;
+    QTimer envTimer;
+    QSenseHatSensors::UpdateFlags envWhat;
+    QTimer dutyTimer;
+    QTimer calibrationTimer;
+    QSenseHatSensors::UpdateFlags dutyWhat;
+
+    bool adaptive = false;
+    bool stationary = false;
+    float accelMean[3] = { 0, 0, 0 };
+    float accelVariance = 0;
+    quint64 lastMotion = 0;
+    QVector<QSenseHatSensorSample> history;
+    int historyPos = 0;
+    QVector<QSenseHatSensorSample> preTrigger;
 
     qreal humidity = 0;
     qreal pressure = 0;
@@ -81,184 +112,225 @@ public:
     QVector3D orientation;
 };
 
-class CLocale
+QSenseHatSensorsPrivate::~QSenseHatSensorsPrivate()
 {
-public:
-    CLocale() {
-        oldLoc = QByteArray(setlocale(LC_ALL, 0));
-        setlocale(LC_ALL, "C");
-    }
-    ~CLocale() {
-        setlocale(LC_ALL, oldLoc.constData());
-    }
-private:
-    QByteArray oldLoc;
-};
+    delete autoPollSubscription;
+    // Whatever the application still holds becomes inert.
+    for (int i = 0; i < subscriptions.count(); ++i)
+        subscriptions.at(i)->d = Q_NULLPTR;
+}
 
-QSenseHatSensorsPrivate::~QSenseHatSensorsPrivate()
+QSenseHatSensorSubscription::~QSenseHatSensorSubscription()
+{
+    if (d)
+        d->unsubscribe(this);
+}
+
+QSenseHatSensorSubscription *QSenseHatSensorsPrivate::subscribe(QSenseHatSensors::UpdateFlags what, qreal maxRate)
+{
+    QSenseHatSensorSubscription *subscription = new QSenseHatSensorSubscription(this, what, qMax(qreal(0), maxRate));
+    subscriptions.append(subscription);
+    reschedule();
+    return subscription;
+}
+
+void QSenseHatSensorsPrivate::unsubscribe(QSenseHatSensorSubscription *subscription)
+{
+    subscriptions.removeOne(subscription);
+    reschedule();
+}
+
+// A rate of 0 means unlimited, -1 no subscribers.
+static inline qreal combinedRate(qreal a, qreal b)
+{
+    return a == 0 || b == 0 ? 0 : qMax(a, b);
+}
+
+static inline int intervalForRate(qreal rate, int minInterval)
+{
+    return rate > 0 ? qMax(minInterval, qRound(1000 / rate)) : minInterval;
+}
+
+static void schedule(QTimer *timer, bool active, int interval)
 {
-    delete rtpressure;
-    delete rthumidity;
-    delete rtimu;
-    delete settings;
-}
-
-void QSenseHatSensorsPrivate::open()
-{
-    CLocale c; // to avoid decimal separator trouble in the ini file
-    const QString configFileName = QStringLiteral("RTIMULib.ini");
-    const QString defaultConfig = QStringLiteral("/etc/") + configFileName;
-    const QString writableConfigDir = QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation) + QStringLiteral("/sense_hat");
-    const QString writableConfig = writableConfigDir + QStringLiteral("/") + configFileName;
-
-    if (!flags.testFlag(QSenseHatSensors::DontCopyIniFile)) {
-        if (!QFile::exists(writableConfig)) {
-            qCDebug(qLcSH) << "Copying" << defaultConfig << "to" << writableConfig;
-            if (QFile::exists(defaultConfig)) {
-                QDir(QStringLiteral("/")).mkpath(writableConfigDir);
-                QFile::copy(defaultConfig, writableConfig);
-            } else {
-                qWarning("/etc/RTIMULib.ini not found, sensors may not be functional");
-            }
+    if (!active)
+        timer->stop();
+    else if (!timer->isActive() || timer->interval() != interval)
+        timer->start(interval);
+}
+
+void QSenseHatSensorsPrivate::reschedule()
+{
+    imuWhat = envWhat = QSenseHatSensors::UpdateFlags();
+    qreal imuRate = -1;
+    qreal envRate = -1;
+    for (int i = 0; i < subscriptions.count(); ++i) {
+        const QSenseHatSensorSubscription *s = subscriptions.at(i);
+        if (s->what() & imuUpdateFlags) {
+            imuWhat |= s->what() & imuUpdateFlags;
+            imuRate = imuRate < 0 ? s->maxRate() : combinedRate(imuRate, s->maxRate());
+        }
+        if (s->what() & envUpdateFlags) {
+            envWhat |= s->what() & envUpdateFlags;
+            envRate = envRate < 0 ? s->maxRate() : combinedRate(envRate, s->maxRate());
         }
-        QByteArray dirName = writableConfigDir.toUtf8();
-        settings = new RTIMUSettings(dirName.constData(), "RTIMULib");
-    } else {
-        settings = new RTIMUSettings("/etc", "RTIMULib");
     }
 
-    rtimu = RTIMU::createIMU(settings);
-    pollInterval = qMax(1, rtimu->IMUGetPollInterval());
-    qCDebug(qLcSH, "IMU name %s Recommended poll interval %d ms", rtimu->IMUName(), pollInterval);
+    imuInterval = intervalForRate(imuRate, core.pollInterval());
+    schedule(&pollTimer, imuRate >= 0, stationary ? qMax(imuInterval, STATIONARY_POLL_INTERVAL_MS) : imuInterval);
+    schedule(&envTimer, envRate >= 0, intervalForRate(envRate, ENV_POLL_INTERVAL_MS));
 
-    rthumidity = RTHumidity::createHumidity(settings);
-    qCDebug(qLcSH, "Humidity sensor name %s", rthumidity->humidityName());
-
-    rtpressure = RTPressure::createPressure(settings);
-    qCDebug(qLcSH, "Pressure sensor name %s", rtpressure->pressureName());
+    // Sensors that are polled anyway keep converting continuously.
+    core.setOneShotConversions(dutyIdle());
 }
 
 void QSenseHatSensorsPrivate::update(QSenseHatSensors::UpdateFlags what)
 {
-    int humFlags = QSenseHatSensors::UpdateHumidity;
-    if (temperatureFromHumidity)
-        humFlags |= QSenseHatSensors::UpdateTemperature;
-    if (what & humFlags) {
-        if (!humidityInited) {
-            humidityInited = true;
-            if (!rthumidity->humidityInit())
-                qWarning("Failed to initialize humidity sensor");
-        }
-        RTIMU_DATA data;
-        if (rthumidity->humidityRead(data))
-            report(data, what & humFlags);
-        else
-            qWarning("Failed to read humidity data");
+    if (!core.read(sample, QSenseHatSensorCore::Channels(QFlag(int(what)))))
+        qWarning("Failed to read sensor data");
+
+    report(sample, what);
+}
+
+void QSenseHatSensorsPrivate::pollImu()
+{
+    if (!adaptive) {
+        update(imuWhat);
+        return;
     }
 
-    int presFlags = QSenseHatSensors::UpdatePressure;
-    if (!temperatureFromHumidity)
-        presFlags |= QSenseHatSensors::UpdateTemperature;
-    if (what & presFlags) {
-        if (!pressureInited) {
-            pressureInited = true;
-            if (!rtpressure->pressureInit())
-                qWarning("Failed to initialize pressure sensor");
-        }
-        RTIMU_DATA data;
-        if (rtpressure->pressureRead(data))
-            report(data, what & presFlags);
-        else
-            qWarning("Failed to read pressure data");
+    // Motion detection needs acceleration and gyro, even when only other channels are reported.
+    const QSenseHatSensors::UpdateFlags what = imuWhat
+            | QSenseHatSensors::UpdateAcceleration | QSenseHatSensors::UpdateGyro;
+    if (!core.read(sample, QSenseHatSensorCore::Channels(QFlag(int(what)))))
+        qWarning("Failed to read sensor data");
+
+    adapt(sample);
+    report(sample, imuWhat);
+}
+
+void QSenseHatSensorsPrivate::dutyCycle()
+{
+    // Reading powers the sensors up and triggers one-shot conversions, then
+    // everything no subscriber keeps polling goes back to sleep.
+    update(dutyWhat);
+    core.suspend(dutyIdle());
+}
+
+// The duty cycled channels on sensors that no subscriber keeps polling. Powering down
+// works per sensor, so one polled channel keeps all channels of its sensor awake.
+QSenseHatSensorCore::Channels QSenseHatSensorsPrivate::dutyIdle() const
+{
+    if (!dutyTimer.isActive())
+        return QSenseHatSensorCore::Channels();
+    const QSenseHatSensorCore::Channels busy = core.sensorChannels(QSenseHatSensorCore::Channels(QFlag(int(imuWhat | envWhat))));
+    return QSenseHatSensorCore::Channels(QFlag(int(dutyWhat))) & ~busy;
+}
+
+void QSenseHatSensorsPrivate::adapt(const QSenseHatSensorSample &sample)
+{
+    const uint needed = QSenseHatSensorCore::Acceleration | QSenseHatSensorCore::Gyro;
+    if ((sample.valid & needed) != needed)
+        return;
+
+    history[historyPos] = sample;
+    historyPos = (historyPos + 1) % history.count();
+
+    // Exponentially weighted variance of the acceleration vector.
+    float diff = 0;
+    for (int i = 0; i < 3; ++i) {
+        const float d = sample.acceleration[i] - accelMean[i];
+        accelMean[i] += VARIANCE_SMOOTHING * d;
+        diff += d * d;
     }
+    accelVariance = (1 - VARIANCE_SMOOTHING) * (accelVariance + VARIANCE_SMOOTHING * diff);
 
-    const int imuFlags = QSenseHatSensors::UpdateGyro | QSenseHatSensors::UpdateAcceleration
-            | QSenseHatSensors::UpdateCompass | QSenseHatSensors::UpdateOrientation;
-    if (what & imuFlags) {
-        if (!imuInited) {
-            imuInited = true;
-            if (!rtimu->IMUInit())
-                qWarning("Failed to initialize IMU");
-        }
-        int attempts = MAX_READ_ATTEMPTS;
-        while (attempts--) {
-            if (rtimu->IMURead())
-                break;
-            usleep(pollInterval * 1000);
+    const float *g = sample.gyro;
+    const float gyroSquared = g[0] * g[0] + g[1] * g[1] + g[2] * g[2];
+    const bool moving = accelVariance > ACCEL_VARIANCE_THRESHOLD
+            || gyroSquared > GYRO_THRESHOLD * GYRO_THRESHOLD;
+
+    if (moving || !lastMotion)
+        lastMotion = sample.timestamp;
+
+    if (moving && stationary)
+        setStationary(false);
+    else if (!stationary && sample.timestamp - lastMotion > quint64(STATIONARY_TIMEOUT_MS) * 1000)
+        setStationary(true);
+}
+
+void QSenseHatSensorsPrivate::setStationary(bool enable)
+{
+    stationary = enable;
+    pollTimer.setInterval(enable ? qMax(imuInterval, STATIONARY_POLL_INTERVAL_MS) : imuInterval);
+
+    if (!enable) {
+        // Keep what led up to the motion, oldest first. While stationary the history is
+        // sampled at STATIONARY_POLL_INTERVAL_MS, so this is context, not the onset itself.
+        preTrigger.clear();
+        for (int i = 0; i < history.count(); ++i) {
+            const QSenseHatSensorSample &s(history.at((historyPos + i) % history.count()));
+            if (s.valid)
+                preTrigger.append(s);
         }
-        if (attempts >= 0)
-            report(rtimu->getIMUData(), what & imuFlags);
-        else
-            qWarning("Failed to read intertial measurement data");
     }
+
+    emit q->stationaryChanged(stationary);
 }
 
-static inline qreal toDeg360(qreal rad)
+static inline QVector3D toVector3D(const float *v)
 {
-    const qreal deg = qRadiansToDegrees(rad);
-    return deg < 0 ? deg + 360 : deg;
+    return QVector3D(v[0], v[1], v[2]);
 }
 
-void QSenseHatSensorsPrivate::report(const RTIMU_DATA &data, QSenseHatSensors::UpdateFlags what)
+void QSenseHatSensorsPrivate::report(const QSenseHatSensorSample &sample, QSenseHatSensors::UpdateFlags what)
 {
+    what &= QSenseHatSensors::UpdateFlags(QFlag(sample.valid));
+
     if (what.testFlag(QSenseHatSensors::UpdateHumidity)) {
-        if (data.humidityValid) {
-            humidity = data.humidity;
-            emit q->humidityChanged(humidity);
-        }
+        humidity = sample.humidity;
+        emit q->humidityChanged(humidity);
     }
 
     if (what.testFlag(QSenseHatSensors::UpdatePressure)) {
-        if (data.pressureValid) {
-            pressure = data.pressure;
-            emit q->pressureChanged(pressure);
-        }
+        pressure = sample.pressure;
+        emit q->pressureChanged(pressure);
     }
 
     if (what.testFlag(QSenseHatSensors::UpdateTemperature)) {
-        if (data.temperatureValid) {
-            temperature = data.temperature;
-            emit q->temperatureChanged(temperature);
-        }
+        temperature = sample.temperature;
+        emit q->temperatureChanged(temperature);
     }
 
     if (what.testFlag(QSenseHatSensors::UpdateGyro)) {
-        if (data.gyroValid) {
-            gyro = QVector3D(data.gyro.x(), data.gyro.y(), data.gyro.z());
-            emit q->gyroChanged(gyro);
-        }
+        gyro = toVector3D(sample.gyro);
+        emit q->gyroChanged(gyro);
     }
 
     if (what.testFlag(QSenseHatSensors::UpdateAcceleration)) {
-        if (data.accelValid) {
-            acceleration = QVector3D(data.accel.x(), data.accel.y(), data.accel.z());
-            emit q->accelerationChanged(acceleration);
-        }
+        acceleration = toVector3D(sample.acceleration);
+        emit q->accelerationChanged(acceleration);
     }
 
     if (what.testFlag(QSenseHatSensors::UpdateCompass)) {
-        if (data.compassValid) {
-            compass = QVector3D(data.compass.x(), data.compass.y(), data.compass.z());
-            emit q->compassChanged(compass);
-        }
+        compass = toVector3D(sample.compass);
+        emit q->compassChanged(compass);
     }
 
     if (what.testFlag(QSenseHatSensors::UpdateOrientation)) {
-        if (data.fusionPoseValid) {
-            orientation = QVector3D(toDeg360(data.fusionPose.x()),  // roll
-                                    toDeg360(data.fusionPose.y()),  // pitch
-                                    toDeg360(data.fusionPose.z())); // yaw
-            emit q->orientationChanged(orientation);
-        }
+        orientation = toVector3D(sample.orientation); // roll, pitch, yaw
+        emit q->orientationChanged(orientation);
     }
 }
 
 QSenseHatSensors::QSenseHatSensors(InitFlags flags)
     : d_ptr(new QSenseHatSensorsPrivate(this, flags))
 {
-    d_ptr->open();
-    d_ptr->pollTimer.setInterval(d_ptr->pollInterval);
-    connect(&d_ptr->pollTimer, &QTimer::timeout, [this] { d_ptr->update(d_ptr->autoPollWhat); });
+    connect(&d_ptr->pollTimer, &QTimer::timeout, [this] { d_ptr->pollImu(); });
+    connect(&d_ptr->envTimer, &QTimer::timeout, [this] { d_ptr->update(d_ptr->envWhat); });
+    connect(&d_ptr->dutyTimer, &QTimer::timeout, [this] { d_ptr->dutyCycle(); });
+    d_ptr->calibrationTimer.setTimerType(Qt::VeryCoarseTimer);
+    connect(&d_ptr->calibrationTimer, &QTimer::timeout, [this] { d_ptr->core.updateCompassCalibration(); });
 }
 
 QSenseHatSensors::~QSenseHatSensors()
@@ -275,12 +347,88 @@ void QSenseHatSensors::poll(UpdateFlags what)
 void QSenseHatSensors::setAutoPoll(bool enable, UpdateFlags what)
 {
     Q_D(QSenseHatSensors);
-    if (enable) {
-        d->autoPollWhat = what;
-        d->pollTimer.start();
-    } else {
-        d->pollTimer.stop();
+    delete d->autoPollSubscription;
+    d->autoPollSubscription = enable ? d->subscribe(what, 0) : Q_NULLPTR;
+}
+
+QSenseHatSensorSubscription *QSenseHatSensors::subscribe(UpdateFlags what, qreal maxRate)
+{
+    Q_D(QSenseHatSensors);
+    return d->subscribe(what, maxRate);
+}
+
+void QSenseHatSensors::setDutyCycle(int interval, UpdateFlags what)
+{
+    Q_D(QSenseHatSensors);
+    if (interval <= 0) {
+        d->dutyTimer.stop();
+        d->core.setOneShotConversions(d->dutyIdle());
+        return;
     }
+
+    // Fusion starts over after each wakeup, so orientation would be meaningless. It is
+    // only available by subscribing to it.
+    d->dutyWhat = what & ~UpdateOrientation;
+    // All wakeups come from this one timer; long intervals need not be precise.
+    d->dutyTimer.setTimerType(interval >= 1000 ? Qt::VeryCoarseTimer : Qt::CoarseTimer);
+    d->dutyTimer.start(interval);
+    d->core.setOneShotConversions(d->dutyIdle());
+    d->dutyCycle();
+}
+
+int QSenseHatSensors::dutyCycle() const
+{
+    Q_D(const QSenseHatSensors);
+    return d->dutyTimer.isActive() ? d->dutyTimer.interval() : 0;
+}
+
+void QSenseHatSensors::setAdaptivePolling(bool enable)
+{
+    Q_D(QSenseHatSensors);
+    if (d->adaptive == enable)
+        return;
+
+    d->adaptive = enable;
+    d->lastMotion = 0;
+    d->history.fill(QSenseHatSensorSample(), enable ? PRETRIGGER_SAMPLES : 0);
+    d->historyPos = 0;
+    if (!enable && d->stationary)
+        d->setStationary(false);
+}
+
+bool QSenseHatSensors::adaptivePolling() const
+{
+    Q_D(const QSenseHatSensors);
+    return d->adaptive;
+}
+
+bool QSenseHatSensors::isStationary() const
+{
+    Q_D(const QSenseHatSensors);
+    return d->stationary;
+}
+
+QVector<QSenseHatSensorSample> QSenseHatSensors::preTriggerSamples() const
+{
+    Q_D(const QSenseHatSensors);
+    return d->preTrigger;
+}
+
+void QSenseHatSensors::setOnlineCompassCalibration(bool enable)
+{
+    Q_D(QSenseHatSensors);
+    d->core.setOnlineCompassCalibration(enable);
+    // New fits are picked up between polls, not while reading.
+    if (d->core.onlineCompassCalibration())
+        d->calibrationTimer.start(COMPASS_CALIBRATION_INTERVAL_MS);
+    else
+        d->calibrationTimer.stop();
+}
+
+bool QSenseHatSensors::onlineCompassCalibration() const
+{
+    Q_D(const QSenseHatSensors);
+    return d->core.onlineCompassCalibration();
 }
 
 qreal QSenseHatSensors::humidity() const
@@ -325,4 +473,10 @@ QVector3D QSenseHatSensors::orientation() const
     return d->orientation;
 }
 
+quint64 QSenseHatSensors::timestamp() const
+{
+    Q_D(const QSenseHatSensors);
+    return d->sample.timestamp;
+}
+
 QT_END_NAMESPACE
@@ -38,13 +38,16 @@
 #define QSENSEHATESENSORS_H
 
 #include <QtSenseHat/qsenseglobal.h>
+#include <QtSenseHat/qsensehatsensorcore.h>
 #include <QtCore/QObject>
+#include <QtCore/QVector>
 #include <QtGui/QVector3D>
 
 QT_BEGIN_NAMESPACE
 
 class QImage;
 class QSenseHatSensorsPrivate;
+class QSenseHatSensorSubscription;
 
 class QSENSEHAT_EXPORT QSenseHatSensors : public QObject
 {
@@ -56,10 +59,14 @@ class QSENSEHAT_EXPORT QSenseHatSensors : public QObject
     Q_PROPERTY(QVector3D acceleration READ acceleration NOTIFY accelerationChanged)
     Q_PROPERTY(QVector3D compass READ compass NOTIFY compassChanged)
     Q_PROPERTY(QVector3D orientation READ orientation NOTIFY orientationChanged)
+    Q_PROPERTY(bool stationary READ isStationary NOTIFY stationaryChanged)
 
 public:
     enum InitFlag {
-        DontCopyIniFile = 0x01
+        DontCopyIniFile = 0x01,
+        NativeEnvironmentalDrivers = 0x02,
+        Simulated = 0x04,
+        OneShotConversions = 0x08
     };
     Q_DECLARE_FLAGS(InitFlags, InitFlag)
 
@@ -80,6 +87,17 @@ public:
 
     void poll(UpdateFlags what = UpdateAll);
     void setAutoPoll(bool enable, UpdateFlags what = UpdateAll);
+    QSenseHatSensorSubscription *subscribe(UpdateFlags what, qreal maxRate = 0);
+    void setDutyCycle(int interval, UpdateFlags what = UpdateAll);
+    int dutyCycle() const;
+
+    void setAdaptivePolling(bool enable);
+    bool adaptivePolling() const;
+    bool isStationary() const;
+    QVector<QSenseHatSensorSample> preTriggerSamples() const;
+
+    void setOnlineCompassCalibration(bool enable);
+    bool onlineCompassCalibration() const;
 
     qreal humidity() const;
     qreal pressure() const;
@@ -88,6 +106,7 @@ public:
     QVector3D acceleration() const;
     QVector3D compass() const;
     QVector3D orientation() const;
+    quint64 timestamp() const;
 
 signals:
     void humidityChanged(qreal value);
@@ -97,6 +116,7 @@ signals:
     void accelerationChanged(const QVector3D &value);
     void compassChanged(const QVector3D &value);
     void orientationChanged(const QVector3D &value);
+    void stationaryChanged(bool stationary);
 
 private:
     Q_DISABLE_COPY(QSenseHatSensors)
@@ -107,6 +127,27 @@ private:
 Q_DECLARE_OPERATORS_FOR_FLAGS(QSenseHatSensors::InitFlags)
 Q_DECLARE_OPERATORS_FOR_FLAGS(QSenseHatSensors::UpdateFlags)
 
+// Keeps the subscribed channels polled at up to maxRate Hz (0 for as fast as the
+// sensors allow) until deleted.
+class QSENSEHAT_EXPORT QSenseHatSensorSubscription
+{
+public:
+    ~QSenseHatSensorSubscription();
+
+    QSenseHatSensors::UpdateFlags what() const { return m_what; }
+    qreal maxRate() const { return m_maxRate; }
+
+private:
+    QSenseHatSensorSubscription(QSenseHatSensorsPrivate *d, QSenseHatSensors::UpdateFlags what, qreal maxRate)
+        : d(d), m_what(what), m_maxRate(maxRate) { }
+    Q_DISABLE_COPY(QSenseHatSensorSubscription)
+    friend class QSenseHatSensorsPrivate;
+
+    QSenseHatSensorsPrivate *d;
+    QSenseHatSensors::UpdateFlags m_what;
+    qreal m_maxRate;
+};
+
 QT_END_NAMESPACE
 
 #endif
@@ -0,0 +1,279 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Sense HAT module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qsensehattextscroller.h"
+#include "qsensehatfb_p.h"
+#include <QtCore/QVarLengthArray>
+#include <QtCore/QVector>
+#include <QtGui/QImage>
+
+QT_BEGIN_NAMESPACE
+
+// 5x7 font for printable ASCII. One byte per column, the least significant bit is the top row.
+static const int GLYPH_WIDTH = 5;
+static const int FIRST_GLYPH = 32;
+static const int LAST_GLYPH = 126;
+static const uchar font5x7[LAST_GLYPH - FIRST_GLYPH + 1][GLYPH_WIDTH] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00 }, // ' '
+    { 0x00, 0x00, 0x5F, 0x00, 0x00 }, // '!'
+    { 0x00, 0x07, 0x00, 0x07, 0x00 }, // '"'
+    { 0x14, 0x7F, 0x14, 0x7F, 0x14 }, // '#'
+    { 0x24, 0x2A, 0x7F, 0x2A, 0x12 }, // '$'
+    { 0x23, 0x13, 0x08, 0x64, 0x62 }, // '%'
+    { 0x36, 0x49, 0x55, 0x22, 0x50 }, // '&'
+    { 0x00, 0x05, 0x03, 0x00, 0x00 }, // apostrophe
+    { 0x00, 0x1C, 0x22, 0x41, 0x00 }, // '('
+    { 0x00, 0x41, 0x22, 0x1C, 0x00 }, // ')'
+    { 0x08, 0x2A, 0x1C, 0x2A, 0x08 }, // '*'
+    { 0x08, 0x08, 0x3E, 0x08, 0x08 }, // '+'
+    { 0x00, 0x50, 0x30, 0x00, 0x00 }, // ','
+    { 0x08, 0x08, 0x08, 0x08, 0x08 }, // '-'
+    { 0x00, 0x60, 0x60, 0x00, 0x00 }, // '.'
+    { 0x20, 0x10, 0x08, 0x04, 0x02 }, // '/'
+    { 0x3E, 0x51, 0x49, 0x45, 0x3E }, // '0'
+    { 0x00, 0x42, 0x7F, 0x40, 0x00 }, // '1'
+    { 0x42, 0x61, 0x51, 0x49, 0x46 }, // '2'
+    { 0x21, 0x41, 0x45, 0x4B, 0x31 }, // '3'
+    { 0x18, 0x14, 0x12, 0x7F, 0x10 }, // '4'
+    { 0x27, 0x45, 0x45, 0x45, 0x39 }, // '5'
+    { 0x3C, 0x4A, 0x49, 0x49, 0x30 }, // '6'
+    { 0x01, 0x71, 0x09, 0x05, 0x03 }, // '7'
+    { 0x36, 0x49, 0x49, 0x49, 0x36 }, // '8'
+    { 0x06, 0x49, 0x49, 0x29, 0x1E }, // '9'
+    { 0x00, 0x36, 0x36, 0x00, 0x00 }, // ':'
+    { 0x00, 0x56, 0x36, 0x00, 0x00 }, // ';'
+    { 0x08, 0x14, 0x22, 0x41, 0x00 }, // '<'
+    { 0x14, 0x14, 0x14, 0x14, 0x14 }, // '='
+    { 0x00, 0x41, 0x22, 0x14, 0x08 }, // '>'
+    { 0x02, 0x01, 0x51, 0x09, 0x06 }, // '?'
+    { 0x32, 0x49, 0x79, 0x41, 0x3E }, // '@'
+    { 0x7E, 0x11, 0x11, 0x11, 0x7E }, // 'A'
+    { 0x7F, 0x49, 0x49, 0x49, 0x36 }, // 'B'
+    { 0x3E, 0x41, 0x41, 0x41, 0x22 }, // 'C'
+    { 0x7F, 0x41, 0x41, 0x22, 0x1C }, // 'D'
+    { 0x7F, 0x49, 0x49, 0x49, 0x41 }, // 'E'
+    { 0x7F, 0x09, 0x09, 0x09, 0x01 }, // 'F'
+    { 0x3E, 0x41, 0x49, 0x49, 0x7A }, // 'G'
+    { 0x7F, 0x08, 0x08, 0x08, 0x7F }, // 'H'
+    { 0x00, 0x41, 0x7F, 0x41, 0x00 }, // 'I'
+    { 0x20, 0x40, 0x41, 0x3F, 0x01 }, // 'J'
+    { 0x7F, 0x08, 0x14, 0x22, 0x41 }, // 'K'
+    { 0x7F, 0x40, 0x40, 0x40, 0x40 }, // 'L'
+    { 0x7F, 0x02, 0x0C, 0x02, 0x7F }, // 'M'
+    { 0x7F, 0x04, 0x08, 0x10, 0x7F }, // 'N'
+    { 0x3E, 0x41, 0x41, 0x41, 0x3E }, // 'O'
+    { 0x7F, 0x09, 0x09, 0x09, 0x06 }, // 'P'
+    { 0x3E, 0x41, 0x51, 0x21, 0x5E }, // 'Q'
+    { 0x7F, 0x09, 0x19, 0x29, 0x46 }, // 'R'
+    { 0x46, 0x49, 0x49, 0x49, 0x31 }, // 'S'
+    { 0x01, 0x01, 0x7F, 0x01, 0x01 }, // 'T'
+    { 0x3F, 0x40, 0x40, 0x40, 0x3F }, // 'U'
+    { 0x1F, 0x20, 0x40, 0x20, 0x1F }, // 'V'
+    { 0x3F, 0x40, 0x38, 0x40, 0x3F }, // 'W'
+    { 0x63, 0x14, 0x08, 0x14, 0x63 }, // 'X'
+    { 0x07, 0x08, 0x70, 0x08, 0x07 }, // 'Y'
+    { 0x61, 0x51, 0x49, 0x45, 0x43 }, // 'Z'
+    { 0x00, 0x7F, 0x41, 0x41, 0x00 }, // '['
+    { 0x02, 0x04, 0x08, 0x10, 0x20 }, // backslash
+    { 0x00, 0x41, 0x41, 0x7F, 0x00 }, // ']'
+    { 0x04, 0x02, 0x01, 0x02, 0x04 }, // '^'
+    { 0x40, 0x40, 0x40, 0x40, 0x40 }, // '_'
+    { 0x00, 0x01, 0x02, 0x04, 0x00 }, // '`'
+    { 0x20, 0x54, 0x54, 0x54, 0x78 }, // 'a'
+    { 0x7F, 0x48, 0x44, 0x44, 0x38 }, // 'b'
+    { 0x38, 0x44, 0x44, 0x44, 0x20 }, // 'c'
+    { 0x38, 0x44, 0x44, 0x48, 0x7F }, // 'd'
+    { 0x38, 0x54, 0x54, 0x54, 0x18 }, // 'e'
+    { 0x08, 0x7E, 0x09, 0x01, 0x02 }, // 'f'
+    { 0x0C, 0x52, 0x52, 0x52, 0x3E }, // 'g'
+    { 0x7F, 0x08, 0x04, 0x04, 0x78 }, // 'h'
+    { 0x00, 0x44, 0x7D, 0x40, 0x00 }, // 'i'
+    { 0x20, 0x40, 0x44, 0x3D, 0x00 }, // 'j'
+    { 0x7F, 0x10, 0x28, 0x44, 0x00 }, // 'k'
+    { 0x00, 0x41, 0x7F, 0x40, 0x00 }, // 'l'
+    { 0x7C, 0x04, 0x18, 0x04, 0x78 }, // 'm'
+    { 0x7C, 0x08, 0x04, 0x04, 0x78 }, // 'n'
+    { 0x38, 0x44, 0x44, 0x44, 0x38 }, // 'o'
+    { 0x7C, 0x14, 0x14, 0x14, 0x08 }, // 'p'
+    { 0x08, 0x14, 0x14, 0x18, 0x7C }, // 'q'
+    { 0x7C, 0x08, 0x04, 0x04, 0x08 }, // 'r'
+    { 0x48, 0x54, 0x54, 0x54, 0x20 }, // 's'
+    { 0x04, 0x3F, 0x44, 0x40, 0x20 }, // 't'
+    { 0x3C, 0x40, 0x40, 0x20, 0x7C }, // 'u'
+    { 0x1C, 0x20, 0x40, 0x20, 0x1C }, // 'v'
+    { 0x3C, 0x40, 0x30, 0x40, 0x3C }, // 'w'
+    { 0x44, 0x28, 0x10, 0x28, 0x44 }, // 'x'
+    { 0x0C, 0x50, 0x50, 0x50, 0x3C }, // 'y'
+    { 0x44, 0x64, 0x54, 0x4C, 0x44 }, // 'z'
+    { 0x00, 0x08, 0x36, 0x41, 0x00 }, // '{'
+    { 0x00, 0x00, 0x7F, 0x00, 0x00 }, // '|'
+    { 0x00, 0x41, 0x36, 0x08, 0x00 }, // '}'
+    { 0x08, 0x04, 0x08, 0x10, 0x08 }, // '~'
+};
+
+static const int SPACE_WIDTH = 3;
+static const int STRIP_PADDING = 8;
+
+class QSenseHatTextScrollerPrivate
+{
+public:
+    void rasterize();
+
+    QString text;
+    QRgb color = qRgb(255, 255, 255);
+    QRgb background = qRgb(0, 0, 0);
+    // One byte per column, text rendered once and then only windowed.
+    QVector<uchar> strip;
+    int position = 0;
+};
+
+void QSenseHatTextScrollerPrivate::rasterize()
+{
+    strip.clear();
+    strip.fill(0, STRIP_PADDING);
+    for (QChar c : text) {
+        const ushort u = c.unicode();
+        if (u == ' ') {
+            for (int i = 0; i < SPACE_WIDTH; ++i)
+                strip.append(0);
+            continue;
+        }
+        const uchar *glyph = font5x7[(u >= FIRST_GLYPH && u <= LAST_GLYPH ? u : '?') - FIRST_GLYPH];
+        // Drop empty columns to get proportional spacing.
+        for (int i = 0; i < GLYPH_WIDTH; ++i) {
+            if (glyph[i])
+                strip.append(glyph[i]);
+        }
+        strip.append(0);
+    }
+    for (int i = 1; i < STRIP_PADDING; ++i)
+        strip.append(0);
+    position = 0;
+}
+
+QSenseHatTextScroller::QSenseHatTextScroller(const QString &text)
+    : d_ptr(new QSenseHatTextScrollerPrivate)
+{
+    setText(text);
+}
+
+QSenseHatTextScroller::~QSenseHatTextScroller()
+{
+    delete d_ptr;
+}
+
+void QSenseHatTextScroller::setText(const QString &text)
+{
+    Q_D(QSenseHatTextScroller);
+    d->text = text;
+    d->rasterize();
+}
+
+QString QSenseHatTextScroller::text() const
+{
+    Q_D(const QSenseHatTextScroller);
+    return d->text;
+}
+
+void QSenseHatTextScroller::setColor(const QColor &color)
+{
+    Q_D(QSenseHatTextScroller);
+    d->color = color.rgb();
+}
+
+QColor QSenseHatTextScroller::color() const
+{
+    Q_D(const QSenseHatTextScroller);
+    return QColor(d->color);
+}
+
+void QSenseHatTextScroller::setBackgroundColor(const QColor &color)
+{
+    Q_D(QSenseHatTextScroller);
+    d->background = color.rgb();
+}
+
+QColor QSenseHatTextScroller::backgroundColor() const
+{
+    Q_D(const QSenseHatTextScroller);
+    return QColor(d->background);
+}
+
+int QSenseHatTextScroller::length() const
+{
+    Q_D(const QSenseHatTextScroller);
+    return d->strip.count() - STRIP_PADDING;
+}
+
+int QSenseHatTextScroller::position() const
+{
+    Q_D(const QSenseHatTextScroller);
+    return d->position;
+}
+
+void QSenseHatTextScroller::setPosition(int position)
+{
+    Q_D(QSenseHatTextScroller);
+    const int len = length();
+    d->position = len > 0 ? ((position % len) + len) % len : 0;
+}
+
+void QSenseHatTextScroller::advance()
+{
+    setPosition(position() + 1);
+}
+
+void QSenseHatTextScroller::render(QImage *target) const
+{
+    Q_D(const QSenseHatTextScroller);
+    if (!target || target->isNull())
+        return;
+
+    const int w = target->width();
+    const int h = target->height();
+    QVarLengthArray<QRgb, 64> pixels(w * h);
+    QRgb *out = pixels.data();
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            const uchar column = d->strip.at((d->position + x) % d->strip.count());
+            *out++ = y < 8 && (column & (1 << y)) ? d->color : d->background;
+        }
+    }
+
+    qt_sensehat_storePixels(target, pixels.constData());
+}
+
+QT_END_NAMESPACE
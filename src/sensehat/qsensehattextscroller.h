@@ -0,0 +1,78 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Sense HAT module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QSENSEHATTEXTSCROLLER_H
+#define QSENSEHATTEXTSCROLLER_H
+
+#include <QtSenseHat/qsenseglobal.h>
+#include <QtCore/QString>
+#include <QtGui/QColor>
+
+QT_BEGIN_NAMESPACE
+
+class QImage;
+class QSenseHatTextScrollerPrivate;
+
+class QSENSEHAT_EXPORT QSenseHatTextScroller
+{
+public:
+    QSenseHatTextScroller(const QString &text = QString());
+    ~QSenseHatTextScroller();
+
+    void setText(const QString &text);
+    QString text() const;
+
+    void setColor(const QColor &color);
+    QColor color() const;
+    void setBackgroundColor(const QColor &color);
+    QColor backgroundColor() const;
+
+    int length() const;
+    int position() const;
+    void setPosition(int position);
+    void advance();
+
+    void render(QImage *target) const;
+
+private:
+    Q_DISABLE_COPY(QSenseHatTextScroller)
+    Q_DECLARE_PRIVATE(QSenseHatTextScroller)
+    QSenseHatTextScrollerPrivate *d_ptr;
+};
+
+QT_END_NAMESPACE
+
+#endif
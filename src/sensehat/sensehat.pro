@@ -7,10 +7,22 @@ CONFIG += c++11
 DEFINES += QSENSEHAT_BUILD_LIB
 
 SOURCES = qsensehatfb.cpp \
-          qsensehatsensors.cpp
+          qsensehatsensors.cpp \
+          qsensehatsensorcore.cpp \
+          qsensehati2c.cpp \
+          qsensehatenvsensors.cpp \
+          qsensehatcompasscalibrator.cpp \
+          qsensehattextscroller.cpp
 
 HEADERS = qsensehatfb.h \
+          qsensehatfb_p.h \
           qsensehatsensors.h \
+          qsensehatsensorcore.h \
+          qsensehatsensorcore_p.h \
+          qsensehati2c_p.h \
+          qsensehatenvsensors_p.h \
+          qsensehatcompasscalibrator_p.h \
+          qsensehattextscroller.h \
           qsenseglobal.h
 
 LIBS += -lRTIMULib
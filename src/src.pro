@@ -1,2 +1,12 @@
 TEMPLATE = subdirs
 SUBDIRS += sensehat
+
+qtHaveModule(sensors) {
+    SUBDIRS += plugins
+    plugins.depends = sensehat
+}
+
+qtHaveModule(quick) {
+    SUBDIRS += imports
+    imports.depends = sensehat
+}
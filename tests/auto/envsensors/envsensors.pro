@@ -0,0 +1,5 @@
+CONFIG += testcase
+TARGET = tst_envsensors
+QT = core testlib sensehat-private
+
+SOURCES = tst_envsensors.cpp
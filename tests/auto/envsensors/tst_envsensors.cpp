@@ -0,0 +1,203 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Sense HAT module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtSenseHat/qsensehatsensorcore.h>
+#include <QtSenseHat/private/qsensehatsensorcore_p.h>
+#include <QtSenseHat/private/qsensehati2c_p.h>
+#include <QtSenseHat/private/qsensehatenvsensors_p.h>
+
+class tst_EnvSensors : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void hts221_data();
+    void hts221();
+    void lps25h_data();
+    void lps25h();
+    void core_data();
+    void core();
+    void notReady();
+};
+
+static const int STATUS_REG = 0x27;
+static const int STATUS_DATA_AVAILABLE = 0x03;
+
+static void addModes()
+{
+    QTest::addColumn<int>("mode");
+    QTest::addColumn<int>("transactions");
+
+    // A single burst read of status and output, plus triggering the conversion in one-shot mode.
+    QTest::newRow("continuous") << int(QSenseHatContinuousConversion) << 1;
+    QTest::newRow("one-shot") << int(QSenseHatOneShotConversion) << 2;
+}
+
+void tst_EnvSensors::hts221_data()
+{
+    addModes();
+}
+
+void tst_EnvSensors::hts221()
+{
+    QFETCH(int, mode);
+    QFETCH(int, transactions);
+
+    QSenseHatSimulatedI2CBus bus;
+    bus.setEnvironment(55, 1000, 25);
+    QSenseHatHts221 hts221(&bus);
+    QVERIFY(hts221.init(QSenseHatConversionMode(mode)));
+
+    for (int i = 0; i < 3; ++i) {
+        bus.resetTransactionCount();
+        float h = 0, t = 0;
+        QVERIFY(hts221.read(&h, &t));
+        QCOMPARE(bus.transactionCount(), transactions);
+        QVERIFY(qAbs(h - 55) < 0.01f);
+        QVERIFY(qAbs(t - 25) < 0.01f);
+    }
+
+    QVERIFY(hts221.powerDown());
+    QCOMPARE(int(bus.registerValue(QSenseHatHts221::Address, 0x20)), 0);
+}
+
+void tst_EnvSensors::lps25h_data()
+{
+    addModes();
+}
+
+void tst_EnvSensors::lps25h()
+{
+    QFETCH(int, mode);
+    QFETCH(int, transactions);
+
+    QSenseHatSimulatedI2CBus bus;
+    bus.setEnvironment(55, 1000, 25);
+    QSenseHatLps25h lps25h(&bus);
+    QVERIFY(lps25h.init(QSenseHatConversionMode(mode)));
+
+    for (int i = 0; i < 3; ++i) {
+        bus.resetTransactionCount();
+        float p = 0, t = 0;
+        QVERIFY(lps25h.read(&p, &t));
+        QCOMPARE(bus.transactionCount(), transactions);
+        QVERIFY(qAbs(p - 1000) < 0.01f);
+        QVERIFY(qAbs(t - 25) < 0.01f);
+    }
+
+    QVERIFY(lps25h.powerDown());
+    QCOMPARE(int(bus.registerValue(QSenseHatLps25h::Address, 0x20)), 0);
+}
+
+void tst_EnvSensors::core_data()
+{
+    QTest::addColumn<int>("flags");
+    QTest::addColumn<int>("transactions");
+
+    QTest::newRow("continuous") << int(QSenseHatSensorCore::Simulated) << 2;
+    QTest::newRow("one-shot") << int(QSenseHatSensorCore::Simulated | QSenseHatSensorCore::OneShotConversions) << 4;
+}
+
+void tst_EnvSensors::core()
+{
+    QFETCH(int, flags);
+    QFETCH(int, transactions);
+
+    QSenseHatSensorCore core(QSenseHatSensorCore::InitFlags(QFlag(flags)));
+    QSenseHatI2CBus *bus = QSenseHatSensorCorePrivate::get(&core)->bus;
+    QVERIFY(bus);
+
+    const QSenseHatSensorCore::Channels env = QSenseHatSensorCore::Humidity
+            | QSenseHatSensorCore::Pressure | QSenseHatSensorCore::Temperature;
+    QSenseHatSensorSample sample;
+    QVERIFY(core.read(sample, env)); // initializes
+
+    bus->resetTransactionCount();
+    QVERIFY(core.read(sample, env));
+    QCOMPARE(bus->transactionCount(), transactions);
+    QCOMPARE(sample.valid, uint(env));
+    QVERIFY(qAbs(sample.humidity - 45) < 0.01f);
+    QVERIFY(qAbs(sample.pressure - 1013.25f) < 0.01f);
+    QVERIFY(qAbs(sample.temperature - 22) < 0.01f);
+}
+
+// Continuous conversions take up to 80 ms to produce the first sample after init().
+void tst_EnvSensors::notReady()
+{
+    QSenseHatSimulatedI2CBus bus;
+    bus.setRegisterValue(QSenseHatHts221::Address, STATUS_REG, 0);
+    bus.setRegisterValue(QSenseHatLps25h::Address, STATUS_REG, 0);
+
+    QSenseHatHts221 hts221(&bus);
+    QSenseHatLps25h lps25h(&bus);
+    QVERIFY(hts221.init(QSenseHatContinuousConversion));
+    QVERIFY(lps25h.init(QSenseHatContinuousConversion));
+
+    float a = -1, b = -1;
+    QVERIFY(hts221.read(&a, &b));
+    QVERIFY(!hts221.hasSample());
+    QVERIFY(lps25h.read(&a, &b));
+    QVERIFY(!lps25h.hasSample());
+    QCOMPARE(a, -1.0f);
+    QCOMPARE(b, -1.0f);
+
+    bus.setRegisterValue(QSenseHatHts221::Address, STATUS_REG, STATUS_DATA_AVAILABLE);
+    QVERIFY(hts221.read(&a, &b));
+    QVERIFY(hts221.hasSample());
+    QVERIFY(qAbs(a - 45) < 0.01f);
+
+    // Through the core, the first read succeeds without the not yet available channels.
+    QSenseHatSensorCore core(QSenseHatSensorCore::Simulated);
+    QSenseHatI2CBus *coreBus = QSenseHatSensorCorePrivate::get(&core)->bus;
+    QSenseHatSimulatedI2CBus *simulated = static_cast<QSenseHatSimulatedI2CBus *>(coreBus);
+    simulated->setRegisterValue(QSenseHatHts221::Address, STATUS_REG, 0);
+    simulated->setRegisterValue(QSenseHatLps25h::Address, STATUS_REG, 0);
+
+    const QSenseHatSensorCore::Channels env = QSenseHatSensorCore::Humidity
+            | QSenseHatSensorCore::Pressure | QSenseHatSensorCore::Temperature;
+    QSenseHatSensorSample sample;
+    QVERIFY(core.read(sample, env));
+    QCOMPARE(sample.valid, 0u);
+
+    simulated->setRegisterValue(QSenseHatLps25h::Address, STATUS_REG, STATUS_DATA_AVAILABLE);
+    QVERIFY(core.read(sample, env));
+    QCOMPARE(sample.valid, uint(QSenseHatSensorCore::Pressure));
+}
+
+QTEST_APPLESS_MAIN(tst_EnvSensors)
+
+#include "tst_envsensors.moc"
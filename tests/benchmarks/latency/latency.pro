@@ -0,0 +1,5 @@
+CONFIG += testcase
+TARGET = tst_bench_latency
+QT = core gui testlib sensehat
+
+SOURCES = tst_latency.cpp
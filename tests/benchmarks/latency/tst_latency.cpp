@@ -0,0 +1,160 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Sense HAT module
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtTest/QtTest>
+#include <QtGui/QImage>
+#include <QtGui/QPainter>
+#include <QtGui/QVector3D>
+#include <QtSenseHat/qsensehatfb.h>
+#include <QtSenseHat/qsensehatsensorcore.h>
+#include <algorithm>
+#include <time.h>
+
+static const int SAMPLE_COUNT = 500;
+static const int DEFAULT_MAX_P99_US = 10000;
+
+static quint64 monotonicUSecs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return quint64(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+class Probe : public QObject
+{
+    Q_OBJECT
+
+signals:
+    void sampled(quint64 started, quint64 acquired, const QVector3D &orientation);
+};
+
+class SensorThread : public QThread
+{
+public:
+    SensorThread(Probe *probe) : probe(probe) { }
+
+protected:
+    void run() Q_DECL_OVERRIDE
+    {
+        QSenseHatSensorCore core(QSenseHatSensorCore::Simulated);
+        if (!core.init(QSenseHatSensorCore::Orientation))
+            return;
+        QSenseHatSensorSample sample;
+        while (!isInterruptionRequested()) {
+            const quint64 started = monotonicUSecs();
+            if (core.read(sample, QSenseHatSensorCore::Orientation)
+                    && (sample.valid & QSenseHatSensorCore::Orientation)) {
+                const QVector3D v(sample.orientation[0], sample.orientation[1], sample.orientation[2]);
+                emit probe->sampled(started, monotonicUSecs(), v);
+            }
+            msleep(core.pollInterval());
+        }
+    }
+
+private:
+    Probe *probe;
+};
+
+static quint64 percentile(QVector<quint64> v, int p)
+{
+    std::sort(v.begin(), v.end());
+    return v.at(qMin(v.count() - 1, v.count() * p / 100));
+}
+
+class tst_Latency : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void motionToLed();
+};
+
+// From the start of the IMU read to the pixels being in the (file-backed) framebuffer.
+void tst_Latency::motionToLed()
+{
+    bool ok = false;
+    quint64 maxP99 = qgetenv("QT_SENSEHAT_LATENCY_MAX_P99").toULongLong(&ok);
+    if (!ok)
+        maxP99 = DEFAULT_MAX_P99_US;
+
+    QTemporaryFile fbFile;
+    QVERIFY(fbFile.open());
+    QSenseHatFb fb(fbFile.fileName());
+    QVERIFY(fb.isValid());
+    QImage frame(fb.size(), QImage::Format_RGB32);
+    QPainter p(&frame);
+
+    QVector<quint64> acquire, delivery, paint, write, total;
+    QEventLoop loop;
+    Probe probe;
+    connect(&probe, &Probe::sampled, &loop, [&](quint64 started, quint64 acquired, const QVector3D &v) {
+        if (total.count() == SAMPLE_COUNT)
+            return;
+        const quint64 delivered = monotonicUSecs();
+        p.fillRect(QRect(QPoint(), fb.size()), QColor::fromHsv(int(v.z()) % 360, 255, 255));
+        const quint64 painted = monotonicUSecs();
+        fb.drawImage(frame);
+        fb.present();
+        const quint64 presented = monotonicUSecs();
+
+        acquire.append(acquired - started);
+        delivery.append(delivered - acquired);
+        paint.append(painted - delivered);
+        write.append(presented - painted);
+        total.append(presented - started);
+        if (total.count() == SAMPLE_COUNT)
+            loop.quit();
+    }, Qt::QueuedConnection);
+
+    SensorThread thread(&probe);
+    thread.start();
+    QTimer::singleShot(60000, &loop, &QEventLoop::quit);
+    loop.exec();
+    thread.requestInterruption();
+    thread.wait();
+
+    QCOMPARE(total.count(), SAMPLE_COUNT);
+    qDebug("p99 acquire %llu delivery %llu paint %llu fb write %llu total %llu us",
+           percentile(acquire, 99), percentile(delivery, 99), percentile(paint, 99),
+           percentile(write, 99), percentile(total, 99));
+    const quint64 p99 = percentile(total, 99);
+    QVERIFY2(p99 <= maxP99, qPrintable(QString::fromLatin1("total p99 %1 us exceeds %2 us").arg(p99).arg(maxP99)));
+}
+
+QTEST_GUILESS_MAIN(tst_Latency)
+
+#include "tst_latency.moc"